@@ -0,0 +1,263 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2012 The University of Utah
+// All rights reserved.
+//
+// This file is distributed under the University of Illinois Open Source
+// License.  See the file COPYING for details.
+//
+//===----------------------------------------------------------------------===//
+
+#if HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include "ASTCache.h"
+
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <sstream>
+#include <unistd.h>
+
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "clang/AST/ASTConsumer.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Decl.h"
+#include "clang/AST/DeclGroup.h"
+#include "clang/Frontend/ASTUnit.h"
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/MultiplexConsumer.h"
+#include "clang/Serialization/ASTWriter.h"
+
+using namespace clang;
+
+ASTCache::ASTCache(const std::string &Dir)
+  : CacheDir(Dir),
+    ASTStream(NULL)
+{
+  bool Existed;
+  llvm::sys::fs::create_directories(CacheDir, Existed);
+}
+
+// 64-bit FNV-1a
+uint64_t ASTCache::hashContent(llvm::StringRef Content)
+{
+  uint64_t Hash = 14695981039346656037ULL;
+  for (llvm::StringRef::iterator I = Content.begin(), E = Content.end();
+       I != E; ++I) {
+    Hash ^= static_cast<unsigned char>(*I);
+    Hash *= 1099511628211ULL;
+  }
+  return Hash;
+}
+
+std::string ASTCache::getTmpPath(const std::string &Path)
+{
+  std::stringstream TmpSS;
+  TmpSS << Path << ".tmp." << getpid();
+  return TmpSS.str();
+}
+
+bool ASTCache::writeFile(const std::string &Path, llvm::StringRef Content)
+{
+  std::string TmpPath = getTmpPath(Path);
+  std::string Err;
+  {
+    llvm::raw_fd_ostream Out(TmpPath.c_str(), Err,
+                             llvm::raw_fd_ostream::F_Binary);
+    if (!Err.empty())
+      return false;
+    Out << Content;
+    Out.close();
+    if (Out.has_error()) {
+      Out.clear_error();
+      unlink(TmpPath.c_str());
+      return false;
+    }
+  }
+
+  // Unlike rename(), link() never replaces a copy which another
+  // process has put there in the meantime
+  bool RV = (!link(TmpPath.c_str(), Path.c_str()) || (errno == EEXIST));
+  unlink(TmpPath.c_str());
+  return RV;
+}
+
+std::string ASTCache::getKeyPath(uint64_t Hash)
+{
+  std::stringstream KeySS;
+  KeySS << CacheDir << "/";
+  KeySS.width(16);
+  KeySS.fill('0');
+  KeySS << std::hex << Hash;
+  return KeySS.str();
+}
+
+// A copy which is there already must hold the same content, because
+// different contents may share the same hash. Never replace an existing
+// copy, because a cached AST records the modification time of its
+// source file.
+bool ASTCache::addFile(const std::string &Path, llvm::StringRef Content)
+{
+  if (access(Path.c_str(), R_OK))
+    return writeFile(Path, Content);
+
+  llvm::OwningPtr<llvm::MemoryBuffer> Buf;
+  if (llvm::MemoryBuffer::getFile(Path, Buf))
+    return false;
+  return (Buf->getBuffer() == Content);
+}
+
+// The key goes into the hash but not into the cached copy of the text,
+// so a text which is parsed with different options gets another entry
+static std::string getHashedContent(llvm::StringRef Content,
+                                    const std::string &Key)
+{
+  std::string HashedContent = Content.str();
+  HashedContent.push_back('\0');
+  HashedContent += Key;
+  return HashedContent;
+}
+
+bool ASTCache::addSource(llvm::StringRef Source, const std::string &Key,
+                         const std::string &Ext)
+{
+  SrcPath = getKeyPath(hashContent(getHashedContent(Source, Key))) + Ext;
+  ASTPath = SrcPath + ".ast";
+
+  if (addFile(SrcPath, Source))
+    return true;
+  SrcPath.clear();
+  ASTPath.clear();
+  return false;
+}
+
+bool ASTCache::addPreamble(llvm::StringRef Preamble, const std::string &Key,
+                           const std::string &Ext)
+{
+  PreambleSrcPath = getKeyPath(hashContent(getHashedContent(Preamble, Key))) +
+                    ".preamble" + Ext;
+  PreamblePCHPath = PreambleSrcPath + ".pch";
+
+  if (addFile(PreambleSrcPath, Preamble))
+    return true;
+  PreambleSrcPath.clear();
+  PreamblePCHPath.clear();
+  return false;
+}
+
+bool ASTCache::hasPreamblePCH(void)
+{
+  return !PreamblePCHPath.empty() && !access(PreamblePCHPath.c_str(), R_OK);
+}
+
+bool ASTCache::hasAST(void)
+{
+  return !ASTPath.empty() && !access(ASTPath.c_str(), R_OK);
+}
+
+ASTUnit *ASTCache::loadAST(CompilerInstance &CI)
+{
+  llvm::IntrusiveRefCntPtr<DiagnosticsEngine> Diags(&CI.getDiagnostics());
+  return ASTUnit::LoadFromASTFile(ASTPath, Diags, CI.getFileSystemOpts());
+}
+
+ASTConsumer *ASTCache::createPCHGenerator(CompilerInstance &CI,
+                                           const std::string &Path)
+{
+  assert(!ASTStream && "AST is being written!");
+  OutASTPath = Path;
+  TmpASTPath = getTmpPath(Path);
+  std::string Err;
+  ASTStream = new llvm::raw_fd_ostream(TmpASTPath.c_str(), Err,
+                                       llvm::raw_fd_ostream::F_Binary);
+  if (!Err.empty()) {
+    delete ASTStream;
+    ASTStream = NULL;
+    return NULL;
+  }
+  return new PCHGenerator(CI.getPreprocessor(), Path, 0, "", ASTStream);
+}
+
+// The PCHGenerator comes first, so the AST is serialized before the
+// transformation gets the translation unit.
+ASTConsumer *ASTCache::createASTWriter(CompilerInstance &CI,
+                                       ASTConsumer *Consumer)
+{
+  ASTConsumer *Writer = createPCHGenerator(CI, ASTPath);
+  if (!Writer)
+    return Consumer;
+
+  ASTConsumer *Consumers[] = {
+    Writer,
+    Consumer
+  };
+  return new MultiplexConsumer(Consumers);
+}
+
+ASTConsumer *ASTCache::createPreambleWriter(CompilerInstance &CI)
+{
+  return createPCHGenerator(CI, PreamblePCHPath);
+}
+
+void ASTCache::commitAST(void)
+{
+  if (!ASTStream)
+    return;
+
+  // The PCHGenerator doesn't write anything if there are errors
+  bool Written = (ASTStream->tell() > 0);
+  ASTStream->close();
+  if (ASTStream->has_error()) {
+    ASTStream->clear_error();
+    Written = false;
+  }
+  delete ASTStream;
+  ASTStream = NULL;
+
+  if (!Written || rename(TmpASTPath.c_str(), OutASTPath.c_str()))
+    unlink(TmpASTPath.c_str());
+}
+
+// Declarations which share their start location were parsed as one
+// declaration group, e.g., "int a, b;" or "struct S {...} s;".
+void ASTCache::replayAST(ASTUnit *AST, ASTConsumer *Consumer)
+{
+  ASTContext &Ctx = AST->getASTContext();
+  Consumer->Initialize(Ctx);
+
+  TranslationUnitDecl *TU = Ctx.getTranslationUnitDecl();
+  llvm::SmallVector<Decl *, 4> Group;
+  for (DeclContext::decl_iterator I = TU->decls_begin(),
+       E = TU->decls_end(); I != E; ++I) {
+    Decl *D = (*I);
+    if (D->isImplicit())
+      continue;
+
+    if (!Group.empty() && (Group.back()->getLocStart() != D->getLocStart())) {
+      Consumer->HandleTopLevelDecl(
+        DeclGroupRef::Create(Ctx, Group.data(), Group.size()));
+      Group.clear();
+    }
+    Group.push_back(D);
+  }
+  if (!Group.empty())
+    Consumer->HandleTopLevelDecl(
+      DeclGroupRef::Create(Ctx, Group.data(), Group.size()));
+
+  Consumer->HandleTranslationUnit(Ctx);
+}
+
+ASTCache::~ASTCache(void)
+{
+  if (ASTStream) {
+    delete ASTStream;
+    unlink(TmpASTPath.c_str());
+  }
+}
@@ -0,0 +1,136 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2012 The University of Utah
+// All rights reserved.
+//
+// This file is distributed under the University of Illinois Open Source
+// License.  See the file COPYING for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef AST_CACHE_H
+#define AST_CACHE_H
+
+#include <string>
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/DataTypes.h"
+
+namespace llvm {
+  class raw_fd_ostream;
+}
+
+namespace clang {
+  class ASTConsumer;
+  class ASTUnit;
+  class CompilerInstance;
+}
+
+// An on-disk cache of serialized ASTs keyed by the content of the source
+// and the options it is parsed with.
+// It also keeps the precompiled preambles, i.e., the leading #include
+// blocks, of sources which are too costly to cache as a whole.
+// The cache directory can be shared by concurrent clang_delta processes:
+// files are written under a temporary name and then renamed, so that
+// readers only ever see complete files.
+class ASTCache {
+
+public:
+
+  explicit ASTCache(const std::string &Dir);
+
+  ~ASTCache(void);
+
+  // Put a copy of Source into the cache unless it's there already.
+  // Key holds everything else the AST depends on, e.g., the language
+  // and the include paths. A cached AST refers to its source file,
+  // so the source must be parsed from getSrcPath() rather than from
+  // the original file. Returns false if the cache cannot be used.
+  bool addSource(llvm::StringRef Source, const std::string &Key,
+                 const std::string &Ext);
+
+  const std::string &getSrcPath(void) {
+    return SrcPath;
+  }
+
+  bool hasAST(void);
+
+  bool isWritingAST(void) {
+    return (ASTStream != NULL);
+  }
+
+  // Returns NULL if the AST cannot be loaded
+  clang::ASTUnit *loadAST(clang::CompilerInstance &CI);
+
+  // Returns a consumer which serializes the AST into the cache besides
+  // forwarding everything to Consumer. It owns Consumer.
+  clang::ASTConsumer *createASTWriter(clang::CompilerInstance &CI,
+                                      clang::ASTConsumer *Consumer);
+
+  // Put a copy of the text of a preamble into the cache unless it's there
+  // already. Key holds everything else the preamble depends on, e.g.,
+  // the include paths.
+  bool addPreamble(llvm::StringRef Preamble, const std::string &Key,
+                   const std::string &Ext);
+
+  const std::string &getPreambleSrcPath(void) {
+    return PreambleSrcPath;
+  }
+
+  const std::string &getPreamblePCHPath(void) {
+    return PreamblePCHPath;
+  }
+
+  bool hasPreamblePCH(void);
+
+  // Returns a consumer which serializes the AST of the preamble
+  clang::ASTConsumer *createPreambleWriter(clang::CompilerInstance &CI);
+
+  // Move the AST written by the consumer from createASTWriter or
+  // createPreambleWriter into place
+  void commitAST(void);
+
+  // Feed the top-level declarations of AST to Consumer the way
+  // ParseAST does
+  static void replayAST(clang::ASTUnit *AST, clang::ASTConsumer *Consumer);
+
+  static uint64_t hashContent(llvm::StringRef Content);
+
+private:
+
+  std::string getTmpPath(const std::string &Path);
+
+  std::string getKeyPath(uint64_t Hash);
+
+  clang::ASTConsumer *createPCHGenerator(clang::CompilerInstance &CI,
+                                         const std::string &Path);
+
+  bool writeFile(const std::string &Path, llvm::StringRef Content);
+
+  bool addFile(const std::string &Path, llvm::StringRef Content);
+
+  const std::string CacheDir;
+
+  std::string SrcPath;
+
+  std::string ASTPath;
+
+  std::string PreambleSrcPath;
+
+  std::string PreamblePCHPath;
+
+  // Where the AST being written goes upon commitAST
+  std::string OutASTPath;
+
+  std::string TmpASTPath;
+
+  llvm::raw_fd_ostream *ASTStream;
+
+  // Unimplemented
+  ASTCache(void);
+
+  ASTCache(const ASTCache &);
+
+  void operator=(const ASTCache &);
+};
+
+#endif
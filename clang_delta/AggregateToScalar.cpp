@@ -131,6 +131,7 @@ void AggregateToScalar::HandleTranslationUnit(ASTContext &Ctx)
     return;
   }
 
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
 
   TransAssert(TheVarDecl && "NULL TheVarDecl!");
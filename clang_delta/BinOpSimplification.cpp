@@ -140,6 +140,7 @@ void BinOpSimplification::HandleTranslationUnit(ASTContext &Ctx)
     return;
   }
 
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
 
   TransAssert(TheFuncDecl && "NULL TheFuncDecl!");
@@ -101,6 +101,7 @@ void CallExprToValue::HandleTranslationUnit(ASTContext &Ctx)
   TransAssert(TheCallExpr && "NULL TheCallExpr!");
   TransAssert(CurrentFD && "NULL CurrentFD");
 
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
 
   NameQueryWrap->TraverseDecl(Ctx.getTranslationUnitDecl());
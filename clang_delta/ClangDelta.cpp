@@ -21,6 +21,9 @@
 
 static TransformationManager *TransMgr;
 
+// Exit status for --check-syntax and --check-syntax-only
+static const int SyntaxErrorExitCode = 2;
+
 static void PrintVersion(void)
 {
   llvm::outs() << "clang_delta " << PACKAGE_VERSION << "\n";
@@ -38,9 +41,12 @@ static void PrintHelpMessage(void)
   llvm::outs() << "  clang_delta ";
   llvm::outs() << "--transformation=<name> ";
   llvm::outs() << "--counter=<number> ";
+  llvm::outs() << "[--to-counter=<number>] ";
   llvm::outs() << "--output=<output_filename> ";
   llvm::outs() << "<source_filename>\n\n";
 
+  llvm::outs() << "  The source is read from stdin if <source_filename> is -\n\n";
+
   llvm::outs() << "clang_delta options:\n";
 
   llvm::outs() << "  --help: ";
@@ -51,8 +57,9 @@ static void PrintHelpMessage(void)
   llvm::outs() << "  --verbose-transformations: ";
   llvm::outs() << "print verbose description messages for all transformations\n";
 
-  llvm::outs() << "  --transformation=<name>: ";
-  llvm::outs() << "specify the transformation\n";
+  llvm::outs() << "  --transformation=<name>[,<name>...]: ";
+  llvm::outs() << "specify the transformation, or a chain of ";
+  llvm::outs() << "transformations applied one after another\n";
 
   llvm::outs() << "  --transformations: ";
   llvm::outs() << "print the names of all available transformations\n";
@@ -60,12 +67,65 @@ static void PrintHelpMessage(void)
   llvm::outs() << "  --query-instances=<name>: ";
   llvm::outs() << "query available transformation instances for a given transformation\n";
 
-  llvm::outs() << "  --counter=<number>: ";
-  llvm::outs() << "specify the instance of the transformation to perform\n";
+  llvm::outs() << "  --list-instances=<name>: ";
+  llvm::outs() << "list the instances of a given transformation as JSON, ";
+  llvm::outs() << "with the source ranges each one removes and their size ";
+  llvm::outs() << "in bytes (only for transformations which support it)\n";
+
+  llvm::outs() << "  --counter=<number>[,<number>...]: ";
+  llvm::outs() << "specify the instance of the transformation to perform; ";
+  llvm::outs() << "a chain takes one counter for all steps or one per step\n";
+
+  llvm::outs() << "  --to-counter=<number>: ";
+  llvm::outs() << "perform all instances from --counter up to this one ";
+  llvm::outs() << "(only for transformations which support it)\n";
+
+  llvm::outs() << "  --order=ast|size: ";
+  llvm::outs() << "the order of the instances which --counter counts in: ";
+  llvm::outs() << "the order of the AST (default) or the number of bytes ";
+  llvm::outs() << "they remove, largest first (only for transformations ";
+  llvm::outs() << "which support --list-instances)\n";
 
   llvm::outs() << "  --output=<filename>: ";
   llvm::outs() << "specify where to output the transformed source code ";
   llvm::outs() << "(default: stdout)\n";
+
+  llvm::outs() << "  --output-fd=<fd>: ";
+  llvm::outs() << "output the transformed source code to an inherited ";
+  llvm::outs() << "file descriptor\n";
+
+  llvm::outs() << "  --input-fd=<fd>: ";
+  llvm::outs() << "read the source code from an inherited file descriptor ";
+  llvm::outs() << "instead of <source_filename>\n";
+
+  llvm::outs() << "  --lang=c|c++: ";
+  llvm::outs() << "specify the language of the source code ";
+  llvm::outs() << "(default: given by the extension of <source_filename>)\n";
+
+  llvm::outs() << "  --check-syntax: ";
+  llvm::outs() << "don't output the transformed source if it doesn't parse; ";
+  llvm::outs() << "exit with status " << SyntaxErrorExitCode << " instead\n";
+
+  llvm::outs() << "  --check-syntax-only: ";
+  llvm::outs() << "only parse the source file; exit with status ";
+  llvm::outs() << SyntaxErrorExitCode << " if it has syntax errors\n";
+
+  llvm::outs() << "  --format: ";
+  llvm::outs() << "only print the source file with canonical formatting, ";
+  llvm::outs() << "which depends on its tokens alone\n";
+
+  llvm::outs() << "  --time-report[=text|json]: ";
+  llvm::outs() << "print the time spent in each phase, the peak RSS and ";
+  llvm::outs() << "the memory used by the AST to stderr\n";
+
+  llvm::outs() << "  --cache-dir=<dir>: ";
+  llvm::outs() << "load the AST from <dir> instead of parsing if the source ";
+  llvm::outs() << "was parsed before, otherwise save it there (the directory ";
+  llvm::outs() << "can be shared by parallel runs); for a source which ";
+  llvm::outs() << "starts with #includes, only the AST of these is saved\n";
+
+  llvm::outs() << "  -I<dir>: ";
+  llvm::outs() << "add <dir> to the include search paths\n";
   llvm::outs() << "\n";
 }
 
@@ -85,6 +145,13 @@ static void Die(const std::string &Message)
   exit(-1);
 }
 
+static void DieOnSyntaxError(const std::string &Message)
+{
+  llvm::outs() << "Error: " << Message << "\n";
+  TransformationManager::Finalize();
+  exit(SyntaxErrorExitCode);
+}
+
 static void HandleOneArgValue(const std::string &ArgValueStr, size_t SepPos)
 {
   if ((SepPos < 1) || (SepPos >= ArgValueStr.length())) {
@@ -101,25 +168,89 @@ static void HandleOneArgValue(const std::string &ArgValueStr, size_t SepPos)
       Die("Invalid transformation[" + ArgValue + "]");
     }
   }
-  else if (!ArgName.compare("query-instances")) {
+  else if (!ArgName.compare("query-instances") || 
+           !ArgName.compare("list-instances")) {
     if (TransMgr->setTransformation(ArgValue)) {
       Die("Invalid transformation[" + ArgValue + "]");
     }
     TransMgr->setQueryInstanceFlag(true);
+    TransMgr->setListInstancesFlag(!ArgName.compare("list-instances"));
     TransMgr->setTransformationCounter(1);
   }
   else if (!ArgName.compare("counter")) {
+    // One counter for all steps of a chain of transformations, or
+    // a comma-separated list with one counter per step
+    std::stringstream TmpSS(ArgValue);
+    std::string CounterStr;
+    bool First = true;
+
+    while (std::getline(TmpSS, CounterStr, ',')) {
+      int Val;
+      std::stringstream CounterSS(CounterStr);
+
+      if (!(CounterSS >> Val) || (Val <= 0))
+        DieOnBadCmdArg("--" + ArgValueStr);
+
+      if (First)
+        TransMgr->setTransformationCounter(Val);
+      else
+        TransMgr->addTransformationCounter(Val);
+      First = false;
+    }
+    if (First)
+      DieOnBadCmdArg("--" + ArgValueStr);
+  }
+  else if (!ArgName.compare("to-counter")) {
     int Val;
     std::stringstream TmpSS(ArgValue);
 
-    if (!(TmpSS >> Val))
+    if (!(TmpSS >> Val) || (Val <= 0))
       DieOnBadCmdArg("--" + ArgValueStr);
 
-    TransMgr->setTransformationCounter(Val);
+    TransMgr->setToCounter(Val);
   }
   else if (!ArgName.compare("output")) {
     TransMgr->setOutputFileName(ArgValue);
   }
+  else if (!ArgName.compare("output-fd") || !ArgName.compare("input-fd")) {
+    int Val;
+    std::stringstream TmpSS(ArgValue);
+
+    if (!(TmpSS >> Val) || (Val < 0))
+      DieOnBadCmdArg("--" + ArgValueStr);
+
+    if (!ArgName.compare("output-fd"))
+      TransMgr->setOutputFD(Val);
+    else
+      TransMgr->setInputFD(Val);
+  }
+  else if (!ArgName.compare("lang")) {
+    if (!ArgValue.compare("c"))
+      TransMgr->setSrcLang(TransLangC);
+    else if (!ArgValue.compare("c++"))
+      TransMgr->setSrcLang(TransLangCXX);
+    else
+      DieOnBadCmdArg("--" + ArgValueStr);
+  }
+  else if (!ArgName.compare("time-report")) {
+    if (!ArgValue.compare("json"))
+      TransMgr->setTimeReport(true);
+    else if (!ArgValue.compare("text"))
+      TransMgr->setTimeReport(false);
+    else
+      DieOnBadCmdArg("--" + ArgValueStr);
+  }
+  else if (!ArgName.compare("order")) {
+    if (!ArgValue.compare("size"))
+      TransMgr->setOrderBySizeFlag(true);
+    else if (!ArgValue.compare("ast"))
+      TransMgr->setOrderBySizeFlag(false);
+    else
+      DieOnBadCmdArg("--" + ArgValueStr);
+  }
+  else if (!ArgName.compare("cache-dir")) {
+    TransMgr->setCacheDir(ArgValue);
+  }
   else {
     DieOnBadCmdArg("--" + ArgValueStr);
   }
@@ -143,6 +274,18 @@ static void HandleOneNoneValueArg(const std::string &ArgStr)
     TransMgr->printTransformations();
     exit(0);
   }
+  else if (!ArgStr.compare("check-syntax")) {
+    TransMgr->setCheckSyntaxFlag(true);
+  }
+  else if (!ArgStr.compare("check-syntax-only")) {
+    TransMgr->setCheckSyntaxOnlyFlag(true);
+  }
+  else if (!ArgStr.compare("format")) {
+    TransMgr->setFormatFlag(true);
+  }
+  else if (!ArgStr.compare("time-report")) {
+    TransMgr->setTimeReport(false);
+  }
   else {
     DieOnBadCmdArg(ArgStr);
   }
@@ -166,6 +309,11 @@ static void HandleOneArg(const char *Arg)
       HandleOneNoneValueArg(SubArgStr);
     }
   }
+  else if (!ArgStr.compare(0, 2, "-I")) {
+    if (ArgStr.length() == 2)
+      DieOnBadCmdArg(ArgStr);
+    TransMgr->addIncludePath(ArgStr.substr(2));
+  }
   else {
     TransMgr->setSrcFileName(ArgStr);
   }
@@ -179,6 +327,23 @@ int main(int argc, char **argv)
   }
 
   std::string ErrorMsg;
+  if (TransMgr->getCheckSyntaxOnlyFlag()) {
+    if (!TransMgr->checkSrcSyntax(ErrorMsg)) {
+      if (TransMgr->syntaxCheckFailed())
+        DieOnSyntaxError(ErrorMsg);
+      Die(ErrorMsg);
+    }
+    TransformationManager::Finalize();
+    return 0;
+  }
+
+  if (TransMgr->getFormatFlag()) {
+    if (!TransMgr->formatSrc(ErrorMsg))
+      Die(ErrorMsg);
+    TransformationManager::Finalize();
+    return 0;
+  }
+
   if (!TransMgr->verify(ErrorMsg))
     Die(ErrorMsg);
 
@@ -186,13 +351,19 @@ int main(int argc, char **argv)
     Die(ErrorMsg);
 
   if (!TransMgr->doTransformation(ErrorMsg)) {
+    if (TransMgr->syntaxCheckFailed())
+      DieOnSyntaxError(ErrorMsg);
     // fail to do transformation
     Die(ErrorMsg);
   }
 
-  if (TransMgr->getQueryInstanceFlag()) 
+  if (TransMgr->getListInstancesFlag())
+    TransMgr->outputInstanceList();
+  else if (TransMgr->getQueryInstanceFlag()) 
     TransMgr->outputNumTransformationInstances();
 
+  TransMgr->outputTimeReport();
+
   TransformationManager::Finalize();
   return 0;
 }
@@ -29,7 +29,7 @@ static const char *DescriptionMsg =
    * the parameter is unused. \n";
 
 static RegisterTransformation<ClassTemplateToClass>
-         Trans("class-template-to-class", DescriptionMsg);
+         Trans("class-template-to-class", DescriptionMsg, TransLangCXX);
 
 class ClassTemplateToClassASTVisitor : public 
   RecursiveASTVisitor<ClassTemplateToClassASTVisitor> {
@@ -205,6 +205,7 @@ void ClassTemplateToClass::HandleTranslationUnit(ASTContext &Ctx)
 
   TransAssert(TheClassTemplateDecl && "NULL TheClassTemplateDecl!");
   TransAssert(RewriteVisitor && "NULL RewriteVisitor!");
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
   rewriteClassTemplateDecls();
   rewriteClassTemplatePartialSpecs();
@@ -101,6 +101,7 @@ void CombineGlobalVarDecl::HandleTranslationUnit(ASTContext &Ctx)
     return;
   }
 
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
 
   doCombination();
@@ -32,6 +32,10 @@ public:
 
   ~CombineGlobalVarDecl(void);
 
+  virtual bool skipFunctionBodies(void) {
+    return true;
+  }
+
 private:
   
   typedef llvm::SmallVector<void *, 20> DeclGroupVector;
@@ -143,6 +143,7 @@ void CombineLocalVarDecl::HandleTranslationUnit(ASTContext &Ctx)
     return;
   }
 
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
 
   doCombination();
@@ -257,6 +257,7 @@ void CopyPropagation::HandleTranslationUnit(ASTContext &Ctx)
 
   TransAssert(CollectionVisitor && "NULL CollectionVisitor!");
 
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
   TransAssert(TheCopyExpr && "NULL TheCopyExpr!");
 
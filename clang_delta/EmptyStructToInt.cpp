@@ -188,6 +188,7 @@ void EmptyStructToInt::HandleTranslationUnit(ASTContext &Ctx)
     return;
   }
 
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
   removeRecordDecls();
   RewriteVisitor->TraverseDecl(Ctx.getTranslationUnitDecl());
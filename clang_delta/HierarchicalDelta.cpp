@@ -0,0 +1,272 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2012 The University of Utah
+// All rights reserved.
+//
+// This file is distributed under the University of Illinois Open Source
+// License.  See the file COPYING for details.
+//
+//===----------------------------------------------------------------------===//
+
+#if HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include "HierarchicalDelta.h"
+
+#include <algorithm>
+#include <cctype>
+
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/DeclCXX.h"
+#include "clang/AST/DeclTemplate.h"
+#include "clang/AST/Stmt.h"
+#include "clang/Basic/SourceManager.h"
+
+#include "TransformationManager.h"
+
+using namespace clang;
+
+static const char *DescriptionMsg =
+"Hierarchical delta debugging over the AST. Siblings are grouped \
+by their nesting level: top-level declarations form level 0, \
+the statements of a function body (or the members of a namespace \
+or a struct) are one level deeper than their parent, and so on. \
+Each instance removes a batch of adjacent siblings, ddmin-style: \
+all of a group first, then halves, quarters, ..., and finally \
+single siblings. Instances of shallower levels come first, so \
+large unneeded constructs go away before their contents are \
+reduced one by one. \n";
+
+static RegisterTransformation<HierarchicalDelta>
+         Trans("hierarchical-delta", DescriptionMsg);
+
+bool HierarchicalDelta::isShallowerGroup(const SiblingGroup *G1,
+                                         const SiblingGroup *G2)
+{
+  return G1->Level < G2->Level;
+}
+
+bool HierarchicalDelta::isRemovableRange(SourceRange Range)
+{
+  SourceLocation StartLoc = Range.getBegin();
+  SourceLocation EndLoc = Range.getEnd();
+  if (StartLoc.isInvalid() || EndLoc.isInvalid())
+    return false;
+
+  // We cannot remove a part of a macro expansion
+  if (StartLoc.isMacroID() || EndLoc.isMacroID())
+    return false;
+
+  FileID MainFileID = SrcManager->getMainFileID();
+  if ((SrcManager->getFileID(StartLoc) != MainFileID) ||
+      (SrcManager->getFileID(EndLoc) != MainFileID))
+    return false;
+
+  return (TheRewriter.getRangeSize(Range) != -1);
+}
+
+void HierarchicalDelta::addSibling(SiblingGroup *Group, SourceRange Range)
+{
+  if (!Group->Siblings.empty()) {
+    SourceRange &LastRange = Group->Siblings.back();
+    // Declarations from the same declaration group share their start
+    // location, e.g., "int a, b;" or "struct S {...} s;".
+    // They can only be removed together.
+    if (LastRange.getBegin() == Range.getBegin()) {
+      if (SrcManager->isBeforeInTranslationUnit(LastRange.getEnd(),
+                                                Range.getEnd()))
+        LastRange.setEnd(Range.getEnd());
+      return;
+    }
+  }
+  Group->Siblings.push_back(Range);
+}
+
+void HierarchicalDelta::collectNestedDecls(Decl *D, unsigned Level)
+{
+  if (FunctionTemplateDecl *FTD = dyn_cast<FunctionTemplateDecl>(D)) {
+    collectNestedDecls(FTD->getTemplatedDecl(), Level);
+    return;
+  }
+
+  if (ClassTemplateDecl *CTD = dyn_cast<ClassTemplateDecl>(D)) {
+    collectNestedDecls(CTD->getTemplatedDecl(), Level);
+    return;
+  }
+
+  if (FunctionDecl *FD = dyn_cast<FunctionDecl>(D)) {
+    if (!FD->doesThisDeclarationHaveABody())
+      return;
+    if (CompoundStmt *CS = dyn_cast_or_null<CompoundStmt>(FD->getBody()))
+      collectStmtGroup(CS, Level + 1);
+    return;
+  }
+
+  if (RecordDecl *RD = dyn_cast<RecordDecl>(D)) {
+    if (RD->isThisDeclarationADefinition())
+      collectDeclGroup(RD, Level + 1);
+    return;
+  }
+
+  if (isa<NamespaceDecl>(D) || isa<LinkageSpecDecl>(D))
+    collectDeclGroup(dyn_cast<DeclContext>(D), Level + 1);
+}
+
+void HierarchicalDelta::collectDeclGroup(DeclContext *Ctx, unsigned Level)
+{
+  SiblingGroup *Group = new SiblingGroup(Level);
+  SiblingGroups.push_back(Group);
+
+  for (DeclContext::decl_iterator I = Ctx->decls_begin(),
+       E = Ctx->decls_end(); I != E; ++I) {
+    Decl *D = (*I);
+    if (D->isImplicit())
+      continue;
+
+    SourceRange Range = D->getSourceRange();
+    if (!isRemovableRange(Range))
+      continue;
+
+    addSibling(Group, Range);
+    collectNestedDecls(D, Level);
+  }
+}
+
+// Statements are not DeclContexts, so walk down through if, for, while,
+// etc. until we reach the next CompoundStmts.
+// Expressions are skipped, i.e., we never look into GNU statement
+// expressions.
+void HierarchicalDelta::collectNestedStmts(Stmt *S, unsigned Level)
+{
+  for (Stmt::child_iterator I = S->child_begin(), E = S->child_end();
+       I != E; ++I) {
+    Stmt *Child = (*I);
+    if (!Child || isa<Expr>(Child))
+      continue;
+
+    if (CompoundStmt *CS = dyn_cast<CompoundStmt>(Child))
+      collectStmtGroup(CS, Level);
+    else
+      collectNestedStmts(Child, Level);
+  }
+}
+
+void HierarchicalDelta::collectStmtGroup(CompoundStmt *CS, unsigned Level)
+{
+  SiblingGroup *Group = new SiblingGroup(Level);
+  SiblingGroups.push_back(Group);
+
+  for (CompoundStmt::body_iterator I = CS->body_begin(),
+       E = CS->body_end(); I != E; ++I) {
+    Stmt *S = (*I);
+    SourceRange Range = S->getSourceRange();
+    if (!isRemovableRange(Range))
+      continue;
+
+    addSibling(Group, Range);
+    if (CompoundStmt *SubCS = dyn_cast<CompoundStmt>(S))
+      collectStmtGroup(SubCS, Level + 1);
+    else
+      collectNestedStmts(S, Level + 1);
+  }
+}
+
+void HierarchicalDelta::doAnalysis(void)
+{
+  std::stable_sort(SiblingGroups.begin(), SiblingGroups.end(),
+                   isShallowerGroup);
+
+  for (SiblingGroupVector::iterator I = SiblingGroups.begin(),
+       E = SiblingGroups.end(); I != E; ++I) {
+    SiblingGroup *Group = (*I);
+    unsigned NumSiblings = Group->Siblings.size();
+    if (!NumSiblings)
+      continue;
+
+    // Same chunk schedule as the line-based pass: start with the whole
+    // group and halve the chunk size until it reaches one.
+    unsigned Chunk = NumSiblings;
+    while (true) {
+      for (unsigned Idx = 0; Idx < NumSiblings; Idx += Chunk) {
+        SiblingBatch Batch(Group, Idx, std::min(Chunk, NumSiblings - Idx));
+        addInstance(getBatchRange(Batch));
+        AllBatches.push_back(Batch);
+      }
+      if (Chunk == 1)
+        break;
+      Chunk = (Chunk + 1) / 2;
+    }
+  }
+}
+
+void HierarchicalDelta::HandleTranslationUnit(ASTContext &Ctx)
+{
+  collectDeclGroup(Ctx.getTranslationUnitDecl(), 0);
+  doAnalysis();
+
+  if (QueryInstanceOnly)
+    return;
+
+  if (TransformationCounter > ValidInstanceNum) {
+    TransError = TransMaxInstanceError;
+    return;
+  }
+
+  mapCounterBySize();
+  for (unsigned I = 0; I < AllBatches.size(); ++I) {
+    if (isInCounterRange(I + 1))
+      TheBatches.push_back(AllBatches[I]);
+  }
+
+  startRewritePhase();
+  Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
+
+  TransAssert(!TheBatches.empty() && "No siblings to remove!");
+
+  for (SiblingBatchVector::iterator I = TheBatches.begin(),
+       E = TheBatches.end(); I != E; ++I) {
+    removeSiblings(*I);
+  }
+
+  if (Ctx.getDiagnostics().hasErrorOccurred() ||
+      Ctx.getDiagnostics().hasFatalErrorOccurred())
+    TransError = TransInternalError;
+}
+
+// Also remove the semicolon following the range if there is one,
+// e.g., for expression statements or struct definitions.
+SourceLocation HierarchicalDelta::getRemovalEndLoc(SourceRange Range)
+{
+  SourceLocation EndLoc = RewriteHelper->getEndLocationFromBegin(Range);
+  const char *Buf = SrcManager->getCharacterData(EndLoc);
+  int Offset = 0;
+  while (isspace(Buf[Offset]))
+    Offset++;
+  if (Buf[Offset] == ';')
+    return EndLoc.getLocWithOffset(Offset);
+  return Range.getEnd();
+}
+
+SourceRange HierarchicalDelta::getBatchRange(const SiblingBatch &Batch)
+{
+  TransAssert(Batch.NumSiblings && "Empty SiblingBatch!");
+  SiblingRangeVector &Siblings = Batch.Group->Siblings;
+  unsigned LastSibling = Batch.FirstSibling + Batch.NumSiblings - 1;
+  SourceLocation StartLoc = Siblings[Batch.FirstSibling].getBegin();
+  SourceLocation EndLoc = getRemovalEndLoc(Siblings[LastSibling]);
+  return SourceRange(StartLoc, EndLoc);
+}
+
+void HierarchicalDelta::removeSiblings(const SiblingBatch &Batch)
+{
+  removeNonOverlappingText(getBatchRange(Batch));
+}
+
+HierarchicalDelta::~HierarchicalDelta(void)
+{
+  for (SiblingGroupVector::iterator I = SiblingGroups.begin(),
+       E = SiblingGroups.end(); I != E; ++I) {
+    delete (*I);
+  }
+}
@@ -0,0 +1,121 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2012 The University of Utah
+// All rights reserved.
+//
+// This file is distributed under the University of Illinois Open Source
+// License.  See the file COPYING for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef HIERARCHICAL_DELTA_H
+#define HIERARCHICAL_DELTA_H
+
+#include <string>
+#include "llvm/ADT/SmallVector.h"
+#include "clang/Basic/SourceLocation.h"
+#include "Transformation.h"
+
+namespace clang {
+  class ASTContext;
+  class DeclContext;
+  class Stmt;
+  class CompoundStmt;
+}
+
+class HierarchicalDelta : public Transformation {
+
+public:
+
+  HierarchicalDelta(const char *TransName, const char *Desc)
+    : Transformation(TransName, Desc)
+  { }
+
+  ~HierarchicalDelta(void);
+
+  virtual bool supportMultipleRewrites(void) {
+    return true;
+  }
+
+  virtual bool supportListInstances(void) {
+    return true;
+  }
+
+private:
+
+  typedef llvm::SmallVector<clang::SourceRange, 16> SiblingRangeVector;
+
+  // All removable children of one node of the AST, e.g., the top-level
+  // declarations of a translation unit or the statements of a
+  // CompoundStmt. Level is the nesting depth of the node.
+  class SiblingGroup {
+  public:
+    explicit SiblingGroup(unsigned L)
+      : Level(L)
+    { }
+
+    unsigned Level;
+
+    SiblingRangeVector Siblings;
+  };
+
+  typedef llvm::SmallVector<SiblingGroup *, 32> SiblingGroupVector;
+
+  // A batch of adjacent siblings removed by one instance
+  class SiblingBatch {
+  public:
+    SiblingBatch(SiblingGroup *G, unsigned First, unsigned Num)
+      : Group(G),
+        FirstSibling(First),
+        NumSiblings(Num)
+    { }
+
+    SiblingGroup *Group;
+
+    unsigned FirstSibling;
+
+    unsigned NumSiblings;
+  };
+
+  typedef llvm::SmallVector<SiblingBatch, 10> SiblingBatchVector;
+
+  static bool isShallowerGroup(const SiblingGroup *G1,
+                               const SiblingGroup *G2);
+
+  virtual void HandleTranslationUnit(clang::ASTContext &Ctx);
+
+  void collectDeclGroup(clang::DeclContext *Ctx, unsigned Level);
+
+  void collectStmtGroup(clang::CompoundStmt *CS, unsigned Level);
+
+  void collectNestedStmts(clang::Stmt *S, unsigned Level);
+
+  void collectNestedDecls(clang::Decl *D, unsigned Level);
+
+  bool isRemovableRange(clang::SourceRange Range);
+
+  void addSibling(SiblingGroup *Group, clang::SourceRange Range);
+
+  void doAnalysis(void);
+
+  clang::SourceRange getBatchRange(const SiblingBatch &Batch);
+
+  void removeSiblings(const SiblingBatch &Batch);
+
+  clang::SourceLocation getRemovalEndLoc(clang::SourceRange Range);
+
+  SiblingGroupVector SiblingGroups;
+
+  // All instances, in the order of their counters
+  SiblingBatchVector AllBatches;
+
+  SiblingBatchVector TheBatches;
+
+  // Unimplemented
+  HierarchicalDelta(void);
+
+  HierarchicalDelta(const HierarchicalDelta &);
+
+  void operator=(const HierarchicalDelta &);
+};
+#endif
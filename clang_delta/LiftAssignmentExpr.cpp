@@ -231,6 +231,7 @@ void LiftAssignmentExpr::HandleTranslationUnit(ASTContext &Ctx)
     return;
   }
 
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
 
   TransAssert(TheFuncDecl && "NULL TheFuncDecl!");
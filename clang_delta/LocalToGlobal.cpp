@@ -136,6 +136,7 @@ void LocalToGlobal::HandleTranslationUnit(ASTContext &Ctx)
   }
 
   TransAssert(TransformationASTVisitor && "NULL TransformationASTVisitor!");
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
   TransAssert(TheFuncDecl && "NULL TheFuncDecl!");
   TransAssert(TheVarDecl && "NULL TheVarDecl!");
@@ -85,6 +85,7 @@ void MoveFunctionBody::HandleTranslationUnit(ASTContext &Ctx)
     return;
   }
 
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
 
   TransAssert(TheFunctionDecl && "NULL TheFunctionDecl!");
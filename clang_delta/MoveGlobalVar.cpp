@@ -73,6 +73,7 @@ void MoveGlobalVar::HandleTranslationUnit(ASTContext &Ctx)
     return;
   }
 
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
 
   if (ThePrintfDecl)
@@ -115,6 +115,7 @@ void ParamToGlobal::HandleTranslationUnit(ASTContext &Ctx)
   TransAssert(RewriteVisitor && "NULL RewriteVisitor!");
   TransAssert(TheFuncDecl && "NULL TheFuncDecl!");
   TransAssert((TheParamPos >= 0) && "Invalid parameter position!");
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
 
   RewriteVisitor->TraverseDecl(Ctx.getTranslationUnitDecl());
@@ -82,6 +82,7 @@ void ParamToLocal::HandleTranslationUnit(ASTContext &Ctx)
   }
 
   TransAssert(RewriteVisitor && "NULL RewriteVisitor!");
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
   TransAssert(TheFuncDecl && "NULL TheFuncDecl!");
   TransAssert((TheParamPos >= 0) && "Invalid parameter position!");
@@ -0,0 +1,196 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2012 The University of Utah
+// All rights reserved.
+//
+// This file is distributed under the University of Illinois Open Source
+// License.  See the file COPYING for details.
+//
+//===----------------------------------------------------------------------===//
+
+#if HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include "PhaseTimer.h"
+
+#include <cassert>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include "clang/AST/ASTConsumer.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/Frontend/MultiplexConsumer.h"
+
+using namespace clang;
+
+// Placed around the transformation inside a MultiplexConsumer, so that
+// the first marker sees the end of parsing and the second one sees the
+// end of the transformation's HandleTranslationUnit.
+class PhaseMarker : public ASTConsumer {
+
+public:
+
+  PhaseMarker(PhaseTimer *T, bool Before)
+    : Timer(T),
+      IsBefore(Before)
+  { }
+
+  virtual void HandleTranslationUnit(ASTContext &Ctx) {
+    if (IsBefore) {
+      Timer->stopPhase(PhaseTimer::PhaseParse);
+      Timer->startPhase(PhaseTimer::PhaseAnalyze);
+    }
+    else {
+      Timer->stopPhase(PhaseTimer::PhaseAnalyze);
+      Timer->stopPhase(PhaseTimer::PhaseRewrite);
+      Timer->setASTMemory(Ctx.getASTAllocatedMemory(),
+                          Ctx.getSideTableAllocatedMemory());
+    }
+  }
+
+private:
+
+  PhaseTimer *Timer;
+
+  bool IsBefore;
+};
+
+PhaseTimer::PhaseTimer(bool JSON)
+  : JSONOutput(JSON),
+    Group("clang_delta phases"),
+    ASTAllocatedMemory(0),
+    ASTSideTableMemory(0)
+{
+  for (int I = 0; I < NumPhases; ++I) {
+    // TimerGroup prints the human-readable report. Don't create
+    // the timers for the JSON report, otherwise the group would
+    // print them to stderr when it goes away.
+    if (JSONOutput)
+      Timers[I] = NULL;
+    else
+      Timers[I] = new llvm::Timer(getPhaseName(static_cast<PhaseKind>(I)),
+                                  Group);
+    Running[I] = false;
+  }
+}
+
+const char *PhaseTimer::getPhaseName(PhaseKind Phase)
+{
+  switch (Phase) {
+  case PhaseInitCompiler:
+    return "init-compiler";
+  case PhaseParse:
+    return "parse";
+  case PhaseAnalyze:
+    return "analyze";
+  case PhaseRewrite:
+    return "rewrite";
+  case PhaseCheckSyntax:
+    return "check-syntax";
+  case PhaseOutput:
+    return "output";
+  default:
+    assert(0 && "Bad phase!");
+  }
+  return "";
+}
+
+void PhaseTimer::startPhase(PhaseKind Phase)
+{
+  if (Running[Phase])
+    return;
+  Running[Phase] = true;
+  if (Timers[Phase])
+    Timers[Phase]->startTimer();
+  StartRecords[Phase] = llvm::TimeRecord::getCurrentTime(true);
+}
+
+void PhaseTimer::stopPhase(PhaseKind Phase)
+{
+  if (!Running[Phase])
+    return;
+  llvm::TimeRecord Elapsed = llvm::TimeRecord::getCurrentTime(false);
+  Elapsed -= StartRecords[Phase];
+  Records[Phase] += Elapsed;
+  if (Timers[Phase])
+    Timers[Phase]->stopTimer();
+  Running[Phase] = false;
+}
+
+ASTConsumer *PhaseTimer::wrapConsumer(ASTConsumer *Consumer)
+{
+  ASTConsumer *Consumers[] = {
+    new PhaseMarker(this, true),
+    Consumer,
+    new PhaseMarker(this, false)
+  };
+  return new MultiplexConsumer(Consumers);
+}
+
+// ru_maxrss is in kilobytes on Linux and in bytes on Darwin
+long PhaseTimer::getPeakRSS(void)
+{
+  struct rusage Usage;
+  if (getrusage(RUSAGE_SELF, &Usage))
+    return -1;
+#ifdef __APPLE__
+  return Usage.ru_maxrss / 1024;
+#else
+  return Usage.ru_maxrss;
+#endif
+}
+
+void PhaseTimer::printJSONReport(llvm::raw_ostream &OS)
+{
+  llvm::TimeRecord Total;
+
+  OS << "{\n";
+  OS << "  \"phases\": {\n";
+  for (int I = 0; I < NumPhases; ++I) {
+    const llvm::TimeRecord &R = Records[I];
+    Total += R;
+    OS << "    \"" << getPhaseName(static_cast<PhaseKind>(I)) << "\": { "
+       << "\"wall\": " << llvm::format("%.6f", R.getWallTime()) << ", "
+       << "\"user\": " << llvm::format("%.6f", R.getUserTime()) << ", "
+       << "\"system\": " << llvm::format("%.6f", R.getSystemTime()) << " }";
+    OS << ((I + 1 < NumPhases) ? ",\n" : "\n");
+  }
+  OS << "  },\n";
+  OS << "  \"total\": { "
+     << "\"wall\": " << llvm::format("%.6f", Total.getWallTime()) << ", "
+     << "\"user\": " << llvm::format("%.6f", Total.getUserTime()) << ", "
+     << "\"system\": " << llvm::format("%.6f", Total.getSystemTime())
+     << " },\n";
+  OS << "  \"peak-rss-kb\": " << getPeakRSS() << ",\n";
+  OS << "  \"ast-allocated-bytes\": " << ASTAllocatedMemory << ",\n";
+  OS << "  \"ast-side-table-bytes\": " << ASTSideTableMemory << "\n";
+  OS << "}\n";
+}
+
+void PhaseTimer::printReport(llvm::raw_ostream &OS)
+{
+  for (int I = 0; I < NumPhases; ++I)
+    stopPhase(static_cast<PhaseKind>(I));
+
+  if (JSONOutput) {
+    printJSONReport(OS);
+    return;
+  }
+
+  Group.print(OS);
+  OS << "  Peak RSS: " << getPeakRSS() << " KB\n";
+  OS << "  ASTContext allocated memory: " << ASTAllocatedMemory
+     << " bytes\n";
+  OS << "  ASTContext side table memory: " << ASTSideTableMemory
+     << " bytes\n";
+}
+
+PhaseTimer::~PhaseTimer(void)
+{
+  for (int I = 0; I < NumPhases; ++I)
+    delete Timers[I];
+}
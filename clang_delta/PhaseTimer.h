@@ -0,0 +1,95 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2012 The University of Utah
+// All rights reserved.
+//
+// This file is distributed under the University of Illinois Open Source
+// License.  See the file COPYING for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef PHASE_TIMER_H
+#define PHASE_TIMER_H
+
+#include <cstddef>
+#include "llvm/Support/Timer.h"
+
+namespace llvm {
+  class raw_ostream;
+}
+
+namespace clang {
+  class ASTConsumer;
+}
+
+// Collects the time spent in each phase of a clang_delta run for
+// --time-report, together with the peak RSS of the process and the
+// memory used by the ASTContext.
+class PhaseTimer {
+
+public:
+
+  typedef enum {
+    PhaseInitCompiler = 0,
+    PhaseParse,
+    PhaseAnalyze,
+    PhaseRewrite,
+    PhaseCheckSyntax,
+    PhaseOutput,
+    NumPhases
+  } PhaseKind;
+
+  explicit PhaseTimer(bool JSON);
+
+  ~PhaseTimer(void);
+
+  void startPhase(PhaseKind Phase);
+
+  void stopPhase(PhaseKind Phase);
+
+  // Returns a consumer which forwards everything to Consumer, and
+  // separates ParseAST from the HandleTranslationUnit of Consumer,
+  // which is timed as analysis until the transformation starts to
+  // rewrite. The returned consumer owns Consumer.
+  clang::ASTConsumer *wrapConsumer(clang::ASTConsumer *Consumer);
+
+  void setASTMemory(size_t AllocatedBytes, size_t SideTableBytes) {
+    ASTAllocatedMemory = AllocatedBytes;
+    ASTSideTableMemory = SideTableBytes;
+  }
+
+  void printReport(llvm::raw_ostream &OS);
+
+private:
+
+  static const char *getPhaseName(PhaseKind Phase);
+
+  static long getPeakRSS(void);
+
+  void printJSONReport(llvm::raw_ostream &OS);
+
+  bool JSONOutput;
+
+  llvm::TimerGroup Group;
+
+  llvm::Timer *Timers[NumPhases];
+
+  llvm::TimeRecord StartRecords[NumPhases];
+
+  llvm::TimeRecord Records[NumPhases];
+
+  bool Running[NumPhases];
+
+  size_t ASTAllocatedMemory;
+
+  size_t ASTSideTableMemory;
+
+  // Unimplemented
+  PhaseTimer(void);
+
+  PhaseTimer(const PhaseTimer &);
+
+  void operator=(const PhaseTimer &);
+};
+
+#endif
@@ -125,6 +125,7 @@ void ReduceArrayDim::HandleTranslationUnit(ASTContext &Ctx)
 
   TransAssert(CollectionVisitor && "NULL CollectionVisitor!");
   TransAssert(RewriteVisitor && "NULL CollectionVisitor!");
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
   TransAssert(TheVarDecl && "NULL TheVarDecl!");
 
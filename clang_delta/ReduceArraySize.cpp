@@ -93,6 +93,7 @@ void ReduceArraySize::HandleTranslationUnit(ASTContext &Ctx)
   }
 
   TransAssert(CollectionVisitor && "NULL CollectionVisitor!");
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
   TransAssert(TheVarDecl && "NULL TheVarDecl!");
   TransAssert((TheDimValue >= 0) && "Bad TheDimValue!");
@@ -32,7 +32,7 @@ does not target those templates with single argument, and skips \
 variadic templates as well. ";
 
 static RegisterTransformation<ReduceClassTemplateParameter>
-         Trans("reduce-class-template-param", DescriptionMsg);
+         Trans("reduce-class-template-param", DescriptionMsg, TransLangCXX);
 
 class ReduceClassTemplateParameterASTVisitor : public 
   RecursiveASTVisitor<ReduceClassTemplateParameterASTVisitor> {
@@ -251,6 +251,7 @@ void ReduceClassTemplateParameter::HandleTranslationUnit(ASTContext &Ctx)
 
   TransAssert(TheClassTemplateDecl && "NULL TheClassTemplateDecl!");
   TransAssert(ArgRewriteVisitor && "NULL ArgRewriteVisitor!");
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
 
   removeParameterFromDecl();
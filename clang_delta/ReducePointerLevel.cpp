@@ -455,6 +455,7 @@ void ReducePointerLevel::HandleTranslationUnit(ASTContext &Ctx)
 
   TransAssert(CollectionVisitor && "NULL CollectionVisitor!");
   TransAssert(RewriteVisitor && "NULL CollectionVisitor!");
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
   TransAssert(TheDecl && "NULL TheDecl!");
 
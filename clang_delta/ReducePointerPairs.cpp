@@ -251,6 +251,7 @@ void ReducePointerPairs::HandleTranslationUnit(ASTContext &Ctx)
     return;
   }
 
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
   TransAssert(TheVarDecl && "NULL TheVarDecl!");
   TransAssert(ThePairedVarDecl && "NULL ThePairedVarDecl!");
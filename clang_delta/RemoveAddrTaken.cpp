@@ -33,7 +33,7 @@ and the argument doesn't have a correponding parameter in function's \
 declaration.\n";
 
 static RegisterTransformation<RemoveAddrTaken>
-         Trans("remove-addr-taken", DescriptionMsg);
+         Trans("remove-addr-taken", DescriptionMsg, TransLangC);
 
 class RemoveAddrTakenCollectionVisitor : public 
   RecursiveASTVisitor<RemoveAddrTakenCollectionVisitor> {
@@ -174,6 +174,7 @@ void RemoveAddrTaken::HandleTranslationUnit(ASTContext &Ctx)
     return;
   }
 
+  startRewritePhase();
   TransAssert(TheUO && "NULL UnaryOperator!");
   rewriteAddrTakenOp(TheUO);
 
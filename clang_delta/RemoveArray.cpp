@@ -106,6 +106,7 @@ void RemoveArray::HandleTranslationUnit(ASTContext &Ctx)
     return;
   }
 
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
   TransAssert(TheArrayVarDecl && "NULL TheArrayVarDecl!");
 
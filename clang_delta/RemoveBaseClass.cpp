@@ -37,7 +37,7 @@ the corresponding subclass. \n";
 // when multi-inheritance is involved.
 
 static RegisterTransformation<RemoveBaseClass>
-         Trans("remove-base-class", DescriptionMsg);
+         Trans("remove-base-class", DescriptionMsg, TransLangCXX);
 
 class RemoveBaseClassBaseVisitor : public 
   RecursiveASTVisitor<RemoveBaseClassBaseVisitor> {
@@ -99,6 +99,7 @@ void RemoveBaseClass::HandleTranslationUnit(ASTContext &Ctx)
 
   TransAssert(TheBaseClass && "TheBaseClass is NULL!");
   TransAssert(TheDerivedClass && "TheDerivedClass is NULL!");
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
 
   RewriteVisitor = 
@@ -27,7 +27,7 @@ static const char *DescriptionMsg =
 "This pass tries to remove an initializer from a Ctor. \n";
 
 static RegisterTransformation<RemoveCtorInitializer>
-         Trans("remove-ctor-initializer", DescriptionMsg);
+         Trans("remove-ctor-initializer", DescriptionMsg, TransLangCXX);
 
 class RemoveCtorInitializerASTVisitor : public 
   RecursiveASTVisitor<RemoveCtorInitializerASTVisitor> {
@@ -105,6 +105,7 @@ void RemoveCtorInitializer::HandleTranslationUnit(ASTContext &Ctx)
 
   TransAssert(TheCtorDecl && "TheCtorDecl is NULL!");
   TransAssert(TheInitializer && "TheInitializer is NULL!");
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
 
   RewriteHelper->removeCXXCtorInitializer(TheInitializer, TheIndex,
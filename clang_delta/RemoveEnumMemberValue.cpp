@@ -76,6 +76,7 @@ void RemoveEnumMemberValue::HandleTranslationUnit(ASTContext &Ctx)
     return;
   }
 
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
 
   TransAssert(TheEnumConstantDecl && "NULL TheEnumConstantDecl!");
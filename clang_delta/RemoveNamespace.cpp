@@ -29,7 +29,7 @@ static const char *DescriptionMsg =
 introducing name conflicts. \n";
 
 static RegisterTransformation<RemoveNamespace>
-         Trans("remove-namespace", DescriptionMsg);
+         Trans("remove-namespace", DescriptionMsg, TransLangCXX);
 
 class RemoveNamespaceASTVisitor : public 
   RecursiveASTVisitor<RemoveNamespaceASTVisitor> {
@@ -670,6 +670,7 @@ void RemoveNamespace::HandleTranslationUnit(ASTContext &Ctx)
 
   TransAssert(RewriteVisitor && "NULL RewriteVisitor!");
   TransAssert(TheNamespaceDecl && "NULL TheNamespaceDecl!");
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
 
   // First rename UsingNamedDecls, i.e., conflicting names
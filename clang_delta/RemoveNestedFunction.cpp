@@ -161,6 +161,7 @@ void RemoveNestedFunction::HandleTranslationUnit(ASTContext &Ctx)
     return;
   }
 
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
 
   TransAssert(TheFuncDecl && "NULL TheFuncDecl!");
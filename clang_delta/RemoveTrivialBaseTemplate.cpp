@@ -28,7 +28,7 @@ static const char *DescriptionMsg =
 template which doesn't have definition. \n";
 
 static RegisterTransformation<RemoveTrivialBaseTemplate>
-         Trans("remove-trivial-base-template", DescriptionMsg);
+         Trans("remove-trivial-base-template", DescriptionMsg, TransLangCXX);
 
 class RemoveTrivialBaseTemplateBaseVisitor : public 
   RecursiveASTVisitor<RemoveTrivialBaseTemplateBaseVisitor> {
@@ -76,6 +76,7 @@ void RemoveTrivialBaseTemplate::HandleTranslationUnit(ASTContext &Ctx)
   }
 
   TransAssert(TheDerivedClass && "TheDerivedClass is NULL!");
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
 
   removeBaseSpecifier();
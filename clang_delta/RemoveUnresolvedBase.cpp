@@ -27,7 +27,7 @@ static const char *DescriptionMsg =
 resolve it. \n";
 
 static RegisterTransformation<RemoveUnresolvedBase>
-         Trans("remove-unresolved-base", DescriptionMsg);
+         Trans("remove-unresolved-base", DescriptionMsg, TransLangCXX);
 
 class RemoveUnresolvedBaseASTVisitor : public 
   RecursiveASTVisitor<RemoveUnresolvedBaseASTVisitor> {
@@ -101,6 +101,7 @@ void RemoveUnresolvedBase::HandleTranslationUnit(ASTContext &Ctx)
 
   TransAssert(TheDerivedClass && "NULL TheDerivedClass!");
   TransAssert(TheBaseSpecifier && "NULL TheBaseSpecifier!");
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
 
   removeBaseSpecifier();
@@ -54,13 +54,9 @@ bool RemoveUnusedEnumMemberAnalysisVisitor::VisitEnumDecl(EnumDecl *ED)
   for (EnumDecl::enumerator_iterator I = ED->enumerator_begin(), E = ED->enumerator_end();
       I != E; ++I) {
     if (!(*I)->isReferenced()) {
-      ConsumerInstance->ValidInstanceNum++;
-      if (ConsumerInstance->ValidInstanceNum ==
-          ConsumerInstance->TransformationCounter) {
-        ConsumerInstance->TheEnumIterator = I;
-        ConsumerInstance->TheEnumDecl = ED;
-        ConsumerInstance->TheEnumIteratorPrevious = Previous;
-      }
+      ConsumerInstance->addInstance((*I)->getSourceRange());
+      ConsumerInstance->UnusedEnumMembers.push_back(
+        RemoveUnusedEnumMember::UnusedEnumMember(ED, I, Previous));
     }
     Previous = I;
   }
@@ -85,6 +81,13 @@ void RemoveUnusedEnumMember::HandleTranslationUnit(ASTContext &Ctx)
     return;
   }
 
+  mapCounterBySize();
+  const UnusedEnumMember &Member = UnusedEnumMembers[TransformationCounter - 1];
+  TheEnumDecl = Member.ED;
+  TheEnumIterator = Member.Iterator;
+  TheEnumIteratorPrevious = Member.Previous;
+
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
 
   TransAssert(TheEnumDecl && "NULL TheEnumDecl!");
@@ -14,6 +14,7 @@
 
 #include <string>
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
 #include "clang/AST/Decl.h"
 #include "Transformation.h"
 
@@ -32,8 +33,30 @@ public:
 
   ~RemoveUnusedEnumMember();
 
+  virtual bool supportListInstances(void) {
+    return true;
+  }
+
 private:
 
+  // An unused enumerator, with its predecessor in the enum
+  class UnusedEnumMember {
+  public:
+    UnusedEnumMember(clang::EnumDecl *E,
+                     clang::EnumDecl::enumerator_iterator I,
+                     clang::EnumDecl::enumerator_iterator P)
+      : ED(E),
+        Iterator(I),
+        Previous(P)
+    { }
+
+    clang::EnumDecl *ED;
+
+    clang::EnumDecl::enumerator_iterator Iterator;
+
+    clang::EnumDecl::enumerator_iterator Previous;
+  };
+
   virtual void Initialize(clang::ASTContext &context);
 
   virtual void HandleTranslationUnit(clang::ASTContext &Ctx);
@@ -42,6 +65,9 @@ private:
 
   RemoveUnusedEnumMemberAnalysisVisitor *AnalysisVisitor;
 
+  // All instances, in the order of their counters
+  llvm::SmallVector<UnusedEnumMember, 10> UnusedEnumMembers;
+
   clang::EnumDecl *TheEnumDecl;
   clang::EnumDecl::enumerator_iterator TheEnumIterator;
   clang::EnumDecl::enumerator_iterator TheEnumIteratorPrevious;
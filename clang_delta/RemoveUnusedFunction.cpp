@@ -47,11 +47,8 @@ bool RUFAnalysisVisitor::VisitFunctionDecl(FunctionDecl *FD)
   if (FD->isReferenced() || FD->isMain())
     return true;
 
-  ConsumerInstance->ValidInstanceNum++;
-  if (ConsumerInstance->ValidInstanceNum == 
-      ConsumerInstance->TransformationCounter) {
-    ConsumerInstance->TheFunctionDecl = FD;
-  }
+  ConsumerInstance->addInstance(FD->getSourceRange());
+  ConsumerInstance->UnusedFunctionDecls.push_back(FD);
   return true;
 }
 
@@ -73,21 +70,32 @@ void RemoveUnusedFunction::HandleTranslationUnit(ASTContext &Ctx)
     return;
   }
 
+  mapCounterBySize();
+  for (unsigned I = 0; I < UnusedFunctionDecls.size(); ++I) {
+    if (isInCounterRange(I + 1))
+      TheFunctionDecls.push_back(UnusedFunctionDecls[I]);
+  }
+
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
 
-  TransAssert(TheFunctionDecl && "NULL TheFunctionDecl!");
+  TransAssert(!TheFunctionDecls.empty() && "No FunctionDecl to remove!");
 
-  removeFunctionDecl();
+  for (llvm::SmallVector<const FunctionDecl *, 10>::iterator
+       I = TheFunctionDecls.begin(), E = TheFunctionDecls.end();
+       I != E; ++I) {
+    removeFunctionDecl(*I);
+  }
 
   if (Ctx.getDiagnostics().hasErrorOccurred() ||
       Ctx.getDiagnostics().hasFatalErrorOccurred())
     TransError = TransInternalError;
 }
 
-void RemoveUnusedFunction::removeFunctionDecl(void)
+void RemoveUnusedFunction::removeFunctionDecl(const FunctionDecl *FD)
 {
-  SourceRange FuncRange = TheFunctionDecl->getSourceRange();
-  TheRewriter.RemoveText(FuncRange);
+  SourceRange FuncRange = FD->getSourceRange();
+  removeNonOverlappingText(FuncRange);
 }
 
 RemoveUnusedFunction::~RemoveUnusedFunction(void)
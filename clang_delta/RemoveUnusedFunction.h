@@ -12,6 +12,7 @@
 #define REMOVE_UNUSED_FUNCTION_H
 
 #include <string>
+#include "llvm/ADT/SmallVector.h"
 #include "Transformation.h"
 
 namespace clang {
@@ -29,23 +30,33 @@ public:
 
   RemoveUnusedFunction(const char *TransName, const char *Desc)
     : Transformation(TransName, Desc),
-      AnalysisVisitor(NULL),
-      TheFunctionDecl(NULL)
+      AnalysisVisitor(NULL)
   { }
 
   ~RemoveUnusedFunction(void);
 
+  virtual bool supportMultipleRewrites(void) {
+    return true;
+  }
+
+  virtual bool supportListInstances(void) {
+    return true;
+  }
+
 private:
   
   virtual void Initialize(clang::ASTContext &context);
 
   virtual void HandleTranslationUnit(clang::ASTContext &Ctx);
 
-  void removeFunctionDecl(void);
+  void removeFunctionDecl(const clang::FunctionDecl *FD);
 
   RUFAnalysisVisitor *AnalysisVisitor;
 
-  clang::FunctionDecl *TheFunctionDecl;
+  // All instances, in the order of their counters
+  llvm::SmallVector<const clang::FunctionDecl *, 10> UnusedFunctionDecls;
+
+  llvm::SmallVector<const clang::FunctionDecl *, 10> TheFunctionDecls;
 
   // Unimplemented
   RemoveUnusedFunction(void);
@@ -132,6 +132,7 @@ void RemoveUnusedStructField::HandleTranslationUnit(ASTContext &Ctx)
     return;
   }
 
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
 
   TransAssert(TheRecordDecl && "NULL TheRecordDecl!");
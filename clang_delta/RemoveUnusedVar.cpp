@@ -52,11 +52,8 @@ bool RemoveUnusedVarAnalysisVisitor::VisitVarDecl(VarDecl *VD)
       VD->isStaticDataMember())
     return true;
 
-  ConsumerInstance->ValidInstanceNum++;
-  if (ConsumerInstance->ValidInstanceNum == 
-      ConsumerInstance->TransformationCounter) {
-    ConsumerInstance->TheVarDecl = VD;
-  }
+  ConsumerInstance->addInstance(VD->getSourceRange());
+  ConsumerInstance->UnusedVarDecls.push_back(VD);
   return true;
 }
 
@@ -101,6 +98,10 @@ void RemoveUnusedVar::HandleTranslationUnit(ASTContext &Ctx)
     return;
   }
 
+  mapCounterBySize();
+  TheVarDecl = UnusedVarDecls[TransformationCounter - 1];
+
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
 
   TransAssert(TheVarDecl && "NULL TheFunctionDecl!");
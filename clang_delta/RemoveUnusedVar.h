@@ -13,6 +13,7 @@
 
 #include <string>
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
 #include "Transformation.h"
 
 namespace clang {
@@ -37,6 +38,10 @@ public:
 
   ~RemoveUnusedVar(void);
 
+  virtual bool supportListInstances(void) {
+    return true;
+  }
+
 private:
   
   virtual void Initialize(clang::ASTContext &context);
@@ -54,6 +59,9 @@ private:
 
   RemoveUnusedVarAnalysisVisitor *AnalysisVisitor;
 
+  // All instances, in the order of their counters
+  llvm::SmallVector<clang::VarDecl *, 10> UnusedVarDecls;
+
   clang::VarDecl *TheVarDecl;
 
   // Unimplemented
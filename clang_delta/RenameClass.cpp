@@ -34,7 +34,7 @@ code shown as below: \n\
   class C : public B {}; \n";
 
 static RegisterTransformation<RenameClass>
-         Trans("rename-class", DescriptionMsg);
+         Trans("rename-class", DescriptionMsg, TransLangCXX);
 
 class RenameClassASTVisitor : public 
   RecursiveASTVisitor<RenameClassASTVisitor> {
@@ -98,6 +98,7 @@ void RenameClass::HandleTranslationUnit(ASTContext &Ctx)
     return;
   }
 
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
 
   RewriteVisitor = 
@@ -195,6 +195,7 @@ void RenameFun::HandleTranslationUnit(ASTContext &Ctx)
   }
 
   TransAssert(RenameVisitor && "NULL RenameVisitor!");
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
 
   RenameVisitor->TraverseDecl(Ctx.getTranslationUnitDecl());
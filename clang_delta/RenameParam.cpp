@@ -168,6 +168,7 @@ void RenameParam::HandleTranslationUnit(ASTContext &Ctx)
   }
 
   TransAssert(RenameVisitor && "NULL RenameVisitor!");
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
 
   RenameVisitor->TraverseDecl(Ctx.getTranslationUnitDecl());
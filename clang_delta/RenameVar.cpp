@@ -165,6 +165,7 @@ void RenameVar::HandleTranslationUnit(ASTContext &Ctx)
   }
 
   TransAssert(RenameVisitor && "NULL RenameVisitor!");
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
 
   collectVars();
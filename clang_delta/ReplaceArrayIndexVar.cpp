@@ -244,6 +244,7 @@ void ReplaceArrayIndexVar::HandleTranslationUnit(ASTContext &Ctx)
     return;
   }
 
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
   doRewrite();
 
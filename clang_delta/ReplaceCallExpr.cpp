@@ -294,6 +294,7 @@ void ReplaceCallExpr::HandleTranslationUnit(ASTContext &Ctx)
   TransAssert(TheCallExpr && "NULL TheCallExpr!");
   TransAssert(TheReturnStmt && "NULL TheReturnStmt");
 
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
 
   replaceCallExpr();
@@ -30,7 +30,7 @@ static const char *DescriptionMsg =
 they require the same number of arguments for instantiation. \n";
 
 static RegisterTransformation<ReplaceDerivedClass>
-         Trans("replace-derived-class", DescriptionMsg);
+         Trans("replace-derived-class", DescriptionMsg, TransLangCXX);
 
 class ReplaceDerivedClassASTVisitor : public 
   RecursiveASTVisitor<ReplaceDerivedClassASTVisitor> {
@@ -90,6 +90,7 @@ void ReplaceDerivedClass::HandleTranslationUnit(ASTContext &Ctx)
 
   TransAssert(TheDerivedClass && "TheDerivedClass is NULL!");
   TransAssert(TheBaseClass && "TheBaseClass is NULL!");
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
 
   RewriteVisitor = 
@@ -139,6 +139,7 @@ void ReplaceSimpleTypedef::HandleTranslationUnit(ASTContext &Ctx)
     return;
   }
 
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
   TransAssert(TheTypedefDecl && "NULL TheTypedefDecl!");
   RewriteVisitor->TraverseDecl(Ctx.getTranslationUnitDecl());
@@ -118,6 +118,7 @@ void ReplaceUndefinedFunction::HandleTranslationUnit(ASTContext &Ctx)
     return;
   }
 
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
   TransAssert(RewriteVisitor && "NULL RewriteVisitor!");
   RewriteVisitor->TraverseDecl(Ctx.getTranslationUnitDecl());
@@ -157,6 +157,7 @@ void ReturnVoid::HandleTranslationUnit(ASTContext &Ctx)
   }
 
   TransAssert(TransformationASTVisitor && "NULL TransformationASTVisitor!");
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
   TransAssert(TheFuncDecl && "NULL TheFuncDecl!");
 
@@ -30,32 +30,13 @@ using namespace llvm;
 
 static const char *DefaultIndentStr = "    ";
 
-RewriteUtils *RewriteUtils::Instance;
-
 const char *RewriteUtils::TmpVarNamePrefix = "__trans_tmp_";
 
-RewriteUtils *RewriteUtils::GetInstance(Rewriter *RW)
-{
-  if (RewriteUtils::Instance) {
-    RewriteUtils::Instance->TheRewriter = RW;
-    RewriteUtils::Instance->SrcManager = &(RW->getSourceMgr());
-    return RewriteUtils::Instance;
-  }
-
-  RewriteUtils::Instance = new RewriteUtils();
-  assert(RewriteUtils::Instance);
-
-  RewriteUtils::Instance->TheRewriter = RW;
-  RewriteUtils::Instance->SrcManager = &(RW->getSourceMgr());
-  return RewriteUtils::Instance;
-}
-
-void RewriteUtils::Finalize(void)
+RewriteUtils::RewriteUtils(Rewriter *RW)
+  : TheRewriter(RW),
+    SrcManager(&(RW->getSourceMgr()))
 {
-  if (RewriteUtils::Instance) {
-    delete RewriteUtils::Instance;
-    RewriteUtils::Instance = NULL;
-  }
+  // Nothing to do
 }
 
 // copied from Rewriter.cpp
@@ -48,11 +48,12 @@ namespace clang {
   class ClassTemplateDecl;
 }
 
+// Each transformation has its own RewriteUtils bound to its Rewriter
 class RewriteUtils {
 public:
-  static RewriteUtils *GetInstance(clang::Rewriter *RW);
+  explicit RewriteUtils(clang::Rewriter *RW);
 
-  static void Finalize(void);
+  ~RewriteUtils(void) { }
 
   clang::SourceLocation getEndLocationFromBegin(clang::SourceRange Range);
 
@@ -231,21 +232,12 @@ public:
 
 private:
 
-  static RewriteUtils *Instance;
-
   static const char *TmpVarNamePrefix;
 
   clang::Rewriter *TheRewriter;
 
   clang::SourceManager *SrcManager;
 
-  RewriteUtils(void)
-  : TheRewriter(NULL),
-    SrcManager(NULL)
-  { }
-
-  ~RewriteUtils(void) { }
-
   int getOffsetUntil(const char *Buf, char Symbol);
 
   int getSkippingOffset(const char *Buf, char Symbol);
@@ -290,6 +282,8 @@ private:
   unsigned getNumArgsWrapper(const clang::Expr *E);
 
   // Unimplemented
+  RewriteUtils(void);
+
   RewriteUtils(const RewriteUtils &);
 
   void operator=(const RewriteUtils &);
@@ -262,6 +262,7 @@ void SimpleInliner::HandleTranslationUnit(ASTContext &Ctx)
   TransAssert(CurrentFD && "NULL CurrentFD!");
   TransAssert(TheCallExpr && "NULL TheCallExpr!");
 
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
 
   NameQueryWrap->TraverseDecl(Ctx.getTranslationUnitDecl());
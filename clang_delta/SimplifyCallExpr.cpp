@@ -103,6 +103,7 @@ void SimplifyCallExpr::HandleTranslationUnit(ASTContext &Ctx)
   TransAssert(TheCallExpr && "NULL TheCallExpr!");
   TransAssert(CurrentFD && "NULL CurrentFD");
 
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
 
   NameQueryWrap->TraverseDecl(Ctx.getTranslationUnitDecl());
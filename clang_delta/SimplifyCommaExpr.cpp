@@ -163,6 +163,7 @@ void SimplifyCommaExpr::HandleTranslationUnit(ASTContext &Ctx)
     return;
   }
 
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
 
   TransAssert(TheStmt && "NULL TheStmt!");
@@ -0,0 +1,179 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2012 The University of Utah
+// All rights reserved.
+//
+// This file is distributed under the University of Illinois Open Source
+// License.  See the file COPYING for details.
+//
+//===----------------------------------------------------------------------===//
+
+#if HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include "SimplifyConditionalExpr.h"
+
+#include "clang/AST/RecursiveASTVisitor.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/Basic/SourceManager.h"
+
+#include "TransformationManager.h"
+
+using namespace clang;
+
+static const char *DescriptionMsg =
+"Replace a conditional expression with one of its operands. \
+It transforms the following code: \n\
+  x = a ? b : c; \n\
+to \n\
+  x = b; \n\
+  x = c; \n\
+or \n\
+  x = a; \n\
+and a GNU conditional expression (a ?: c) to a or c. \
+The outermost conditional expressions are tried first, so \
+that their nested ones go away with them. \n";
+
+static RegisterTransformation<SimplifyConditionalExpr>
+         Trans("simplify-conditional-expr", DescriptionMsg);
+
+class SimplifyConditionalExprVisitor : public
+  RecursiveASTVisitor<SimplifyConditionalExprVisitor> {
+
+public:
+
+  explicit SimplifyConditionalExprVisitor(SimplifyConditionalExpr *Instance)
+    : ConsumerInstance(Instance)
+  { }
+
+  bool VisitParenExpr(ParenExpr *PE);
+
+  bool VisitConditionalOperator(ConditionalOperator *CO);
+
+  bool VisitBinaryConditionalOperator(BinaryConditionalOperator *BCO);
+
+private:
+
+  SimplifyConditionalExpr *ConsumerInstance;
+};
+
+// A ParenExpr is visited before its subexpression
+bool SimplifyConditionalExprVisitor::VisitParenExpr(ParenExpr *PE)
+{
+  const AbstractConditionalOperator *CO =
+    dyn_cast<AbstractConditionalOperator>(PE->getSubExpr());
+  if (CO)
+    ConsumerInstance->ParenthesizedConditionals.insert(CO);
+  return true;
+}
+
+// The instances of a conditional expression are counted before those
+// of the conditional expressions in its operands
+bool SimplifyConditionalExprVisitor::VisitConditionalOperator(
+       ConditionalOperator *CO)
+{
+  if (!ConsumerInstance->isRewritable(CO) ||
+      !ConsumerInstance->isRewritable(CO->getCond()) ||
+      !ConsumerInstance->isRewritable(CO->getTrueExpr()) ||
+      !ConsumerInstance->isRewritable(CO->getFalseExpr()))
+    return true;
+
+  ConsumerInstance->handleOneOperand(CO, CO->getTrueExpr());
+  ConsumerInstance->handleOneOperand(CO, CO->getFalseExpr());
+  ConsumerInstance->handleOneOperand(CO, CO->getCond());
+  return true;
+}
+
+// The condition is the true operand as well
+bool SimplifyConditionalExprVisitor::VisitBinaryConditionalOperator(
+       BinaryConditionalOperator *BCO)
+{
+  if (!ConsumerInstance->isRewritable(BCO) ||
+      !ConsumerInstance->isRewritable(BCO->getCommon()) ||
+      !ConsumerInstance->isRewritable(BCO->getFalseExpr()))
+    return true;
+
+  ConsumerInstance->handleOneOperand(BCO, BCO->getCommon());
+  ConsumerInstance->handleOneOperand(BCO, BCO->getFalseExpr());
+  return true;
+}
+
+void SimplifyConditionalExpr::Initialize(ASTContext &context)
+{
+  Transformation::Initialize(context);
+  CollectionVisitor = new SimplifyConditionalExprVisitor(this);
+}
+
+void SimplifyConditionalExpr::HandleTranslationUnit(ASTContext &Ctx)
+{
+  CollectionVisitor->TraverseDecl(Ctx.getTranslationUnitDecl());
+
+  if (QueryInstanceOnly)
+    return;
+
+  if (TransformationCounter > ValidInstanceNum) {
+    TransError = TransMaxInstanceError;
+    return;
+  }
+
+  TransAssert(TheConditional && "NULL TheConditional!");
+  TransAssert(TheOperand && "NULL TheOperand!");
+
+  startRewritePhase();
+  Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
+
+  simplifyConditionalExpr();
+
+  if (Ctx.getDiagnostics().hasErrorOccurred() ||
+      Ctx.getDiagnostics().hasFatalErrorOccurred())
+    TransError = TransInternalError;
+}
+
+// Expressions from macro expansions have no text of their own to
+// rewrite
+bool SimplifyConditionalExpr::isRewritable(const Expr *E)
+{
+  SourceRange Range = E->getSourceRange();
+  if (Range.getBegin().isMacroID() || Range.getEnd().isMacroID())
+    return false;
+  return (TheRewriter.getRangeSize(Range) != -1);
+}
+
+void SimplifyConditionalExpr::handleOneOperand(
+       const AbstractConditionalOperator *CO, const Expr *Operand)
+{
+  ValidInstanceNum++;
+  if (TransformationCounter != ValidInstanceNum)
+    return;
+
+  TheConditional = CO;
+  TheOperand = Operand;
+}
+
+void SimplifyConditionalExpr::simplifyConditionalExpr(void)
+{
+  std::string OperandStr;
+  RewriteHelper->getExprString(TheOperand, OperandStr);
+
+  // An operand which is a primary expression or a postfix one binds
+  // at least as tightly as anything around the conditional expression
+  const Expr *E = TheOperand->IgnoreImpCasts();
+  bool NeedParen =
+    !(ParenthesizedConditionals.count(TheConditional) ||
+      isa<ParenExpr>(E) || isa<DeclRefExpr>(E) ||
+      isa<IntegerLiteral>(E) || isa<FloatingLiteral>(E) ||
+      isa<CharacterLiteral>(E) || isa<StringLiteral>(E) ||
+      (isa<CallExpr>(E) && !isa<CXXOperatorCallExpr>(E)) ||
+      isa<ArraySubscriptExpr>(E) ||
+      isa<MemberExpr>(E));
+  if (NeedParen)
+    OperandStr = "(" + OperandStr + ")";
+
+  RewriteHelper->replaceExpr(TheConditional, OperandStr);
+}
+
+SimplifyConditionalExpr::~SimplifyConditionalExpr(void)
+{
+  delete CollectionVisitor;
+}
@@ -0,0 +1,72 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2012 The University of Utah
+// All rights reserved.
+//
+// This file is distributed under the University of Illinois Open Source
+// License.  See the file COPYING for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SIMPLIFY_CONDITIONAL_EXPR_H
+#define SIMPLIFY_CONDITIONAL_EXPR_H
+
+#include <string>
+#include "llvm/ADT/SmallPtrSet.h"
+#include "Transformation.h"
+
+namespace clang {
+  class ASTContext;
+  class Expr;
+  class AbstractConditionalOperator;
+}
+
+class SimplifyConditionalExprVisitor;
+
+class SimplifyConditionalExpr : public Transformation {
+friend class SimplifyConditionalExprVisitor;
+
+public:
+
+  SimplifyConditionalExpr(const char *TransName, const char *Desc)
+    : Transformation(TransName, Desc),
+      CollectionVisitor(NULL),
+      TheConditional(NULL),
+      TheOperand(NULL)
+  { }
+
+  ~SimplifyConditionalExpr(void);
+
+private:
+
+  virtual void Initialize(clang::ASTContext &context);
+
+  virtual void HandleTranslationUnit(clang::ASTContext &Ctx);
+
+  bool isRewritable(const clang::Expr *E);
+
+  void handleOneOperand(const clang::AbstractConditionalOperator *CO,
+                        const clang::Expr *Operand);
+
+  void simplifyConditionalExpr(void);
+
+  SimplifyConditionalExprVisitor *CollectionVisitor;
+
+  // The conditional operators which are the whole of a parenthesized
+  // expression, so that their replacements need no parentheses
+  llvm::SmallPtrSet<const clang::AbstractConditionalOperator *, 10>
+    ParenthesizedConditionals;
+
+  const clang::AbstractConditionalOperator *TheConditional;
+
+  // The operand which replaces TheConditional
+  const clang::Expr *TheOperand;
+
+  // Unimplemented
+  SimplifyConditionalExpr(void);
+
+  SimplifyConditionalExpr(const SimplifyConditionalExpr &);
+
+  void operator=(const SimplifyConditionalExpr &);
+};
+#endif
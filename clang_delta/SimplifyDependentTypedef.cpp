@@ -37,7 +37,7 @@ to \n\
   };\n";
 
 static RegisterTransformation<SimplifyDependentTypedef>
-         Trans("simplify-dependent-typedef", DescriptionMsg);
+         Trans("simplify-dependent-typedef", DescriptionMsg, TransLangCXX);
 
 class DependentTypedefCollectionVisitor : public
   RecursiveASTVisitor<DependentTypedefCollectionVisitor> {
@@ -131,6 +131,7 @@ void SimplifyDependentTypedef::HandleTranslationUnit(ASTContext &Ctx)
     return;
   }
 
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
   TransAssert(TheTypedefDecl && "NULL TheTypedefDecl!");
   TransAssert(FirstTmplTypeParmD && "NULL FirstTmplTypeParmD!");
@@ -173,6 +173,7 @@ void SimplifyIf::HandleTranslationUnit(ASTContext &Ctx)
     return;
   }
 
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
 
   TransAssert(TheIfStmt && "NULL TheIfStmt");
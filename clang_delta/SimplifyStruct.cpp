@@ -39,7 +39,7 @@ In the above code, struct S2 will be replaced with struct S1, including\n\
 all its referenced. \n";
 
 static RegisterTransformation<SimplifyStruct>
-         Trans("simplify-struct", DescriptionMsg);
+         Trans("simplify-struct", DescriptionMsg, TransLangC);
 
 class SimplifyStructCollectionVisitor : public 
   RecursiveASTVisitor<SimplifyStructCollectionVisitor> {
@@ -301,6 +301,7 @@ void SimplifyStruct::HandleTranslationUnit(ASTContext &Ctx)
     return;
   }
 
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
 
   TransAssert(RewriteVisitor && "NULL RewriteVisitor!");
@@ -136,6 +136,7 @@ void SimplifyStructUnionDecl::HandleTranslationUnit(ASTContext &Ctx)
     return;
   }
 
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
 
   TransAssert(AnalysisVisitor && "NULL AnalysisVisitor!");
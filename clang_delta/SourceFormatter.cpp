@@ -0,0 +1,279 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2012 The University of Utah
+// All rights reserved.
+//
+// This file is distributed under the University of Illinois Open Source
+// License.  See the file COPYING for details.
+//
+//===----------------------------------------------------------------------===//
+
+#if HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include "SourceFormatter.h"
+
+#include <cstring>
+
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "clang/Basic/LangOptions.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Lex/Lexer.h"
+#include "clang/Lex/Token.h"
+
+using namespace clang;
+
+SourceFormatter::SourceFormatter(const SourceManager &SM,
+                                 const LangOptions &LOpts)
+  : SrcManager(SM),
+    LangOpts(LOpts),
+    Out(NULL),
+    IndentLevel(0),
+    ParenDepth(0),
+    AtLineStart(true),
+    PendingNewLine(false),
+    PrevKind(tok::unknown),
+    PrevIsUnary(false)
+{
+  // Nothing to do
+}
+
+// Identifiers (and keywords, which the raw lexer doesn't tell apart),
+// numbers and literals, which need a space between each other. Unknown
+// characters are kept apart from everything as well.
+bool SourceFormatter::isWordLike(tok::TokenKind Kind)
+{
+  switch (Kind) {
+  case tok::raw_identifier:
+  case tok::numeric_constant:
+  case tok::char_constant:
+  case tok::wide_char_constant:
+  case tok::utf16_char_constant:
+  case tok::utf32_char_constant:
+  case tok::string_literal:
+  case tok::wide_string_literal:
+  case tok::utf8_string_literal:
+  case tok::utf16_string_literal:
+  case tok::utf32_string_literal:
+  case tok::unknown:
+    return true;
+  default:
+    return false;
+  }
+}
+
+// Whether a following +, -, *, &, ++ or -- is a binary or postfix
+// operator rather than a unary one
+bool SourceFormatter::isOperandEnd(tok::TokenKind Kind, StringRef Text)
+{
+  if (Kind == tok::raw_identifier)
+    return !(Text == "return" || Text == "case" || Text == "sizeof" ||
+             Text == "throw" || Text == "else" || Text == "do" ||
+             Text == "delete");
+  switch (Kind) {
+  case tok::r_paren:
+  case tok::r_square:
+    return true;
+  default:
+    return (isWordLike(Kind) && (Kind != tok::unknown));
+  }
+}
+
+// Keywords which are followed by a space before their parenthesis,
+// unlike the name of a function in a call
+bool SourceFormatter::isControlKeyword(StringRef Text)
+{
+  return (Text == "if" || Text == "for" || Text == "while" ||
+          Text == "switch" || Text == "catch" || Text == "return");
+}
+
+// Conservatively, whether two punctuators could run together into a
+// different token, e.g., + and + or < and :
+bool SourceFormatter::mayJoin(char Left, char Right)
+{
+  static const char *Joining = "+-*/%&|^<>=!:.#";
+  return (strchr(Joining, Left) && strchr(Joining, Right));
+}
+
+bool SourceFormatter::needSpace(tok::TokenKind Kind, StringRef Text)
+{
+  if (isWordLike(PrevKind) && isWordLike(Kind))
+    return true;
+  if (mayJoin(PrevText.back(), Text[0]))
+    return true;
+  // a number such as 1. would run into a following member access
+  if ((PrevKind == tok::numeric_constant) && (Text[0] == '.'))
+    return true;
+  if ((PrevKind == tok::comment) || (Kind == tok::comment))
+    return true;
+
+  switch (Kind) {
+  case tok::comma:
+  case tok::semi:
+  case tok::r_paren:
+  case tok::r_square:
+  case tok::period:
+  case tok::arrow:
+  case tok::coloncolon:
+    return false;
+  case tok::l_paren:
+  case tok::l_square:
+    // calls and subscripts
+    if (PrevKind == tok::raw_identifier)
+      return isControlKeyword(PrevText);
+    return !((PrevKind == tok::r_paren) || (PrevKind == tok::r_square));
+  case tok::plusplus:
+  case tok::minusminus:
+    if (isOperandEnd(PrevKind, PrevText))
+      return false;
+    break;
+  default:
+    break;
+  }
+
+  switch (PrevKind) {
+  case tok::l_paren:
+  case tok::l_square:
+  case tok::period:
+  case tok::arrow:
+  case tok::coloncolon:
+  case tok::tilde:
+  case tok::exclaim:
+    return false;
+  default:
+    return !PrevIsUnary;
+  }
+}
+
+// The tokens which continue the line of a }
+bool SourceFormatter::staysOnLine(tok::TokenKind Kind, StringRef Text)
+{
+  switch (Kind) {
+  case tok::semi:
+  case tok::comma:
+  case tok::r_paren:
+    return true;
+  case tok::raw_identifier:
+    return (Text == "else");
+  default:
+    return false;
+  }
+}
+
+void SourceFormatter::newLine(void)
+{
+  if (AtLineStart)
+    return;
+  *Out << '\n';
+  AtLineStart = true;
+}
+
+void SourceFormatter::emitToken(tok::TokenKind Kind, StringRef Text)
+{
+  if (PendingNewLine) {
+    PendingNewLine = false;
+    if (!staysOnLine(Kind, Text))
+      newLine();
+  }
+  if (Kind == tok::r_brace) {
+    if (IndentLevel)
+      IndentLevel--;
+    newLine();
+  }
+
+  if (AtLineStart)
+    Out->indent(IndentLevel * IndentWidth);
+  else if (needSpace(Kind, Text))
+    *Out << ' ';
+  *Out << Text;
+  AtLineStart = false;
+
+  switch (Kind) {
+  case tok::star:
+  case tok::amp:
+  case tok::plus:
+  case tok::minus:
+  case tok::plusplus:
+  case tok::minusminus:
+    PrevIsUnary = !isOperandEnd(PrevKind, PrevText);
+    break;
+  default:
+    PrevIsUnary = false;
+    break;
+  }
+  PrevKind = Kind;
+  PrevText = Text;
+
+  switch (Kind) {
+  case tok::l_paren:
+  case tok::l_square:
+    ParenDepth++;
+    break;
+  case tok::r_paren:
+  case tok::r_square:
+    if (ParenDepth)
+      ParenDepth--;
+    break;
+  case tok::l_brace:
+    IndentLevel++;
+    newLine();
+    break;
+  case tok::r_brace:
+    PendingNewLine = true;
+    break;
+  case tok::semi:
+    // but not in the header of a for loop
+    if (!ParenDepth)
+      newLine();
+    break;
+  case tok::comment:
+    if (Text.startswith("//"))
+      newLine();
+    break;
+  default:
+    break;
+  }
+}
+
+void SourceFormatter::emitDirective(StringRef Text)
+{
+  PendingNewLine = false;
+  newLine();
+  *Out << Text << '\n';
+  AtLineStart = true;
+  PrevKind = tok::unknown;
+  PrevText = StringRef();
+  PrevIsUnary = false;
+}
+
+void SourceFormatter::format(FileID FID, llvm::raw_ostream &OS)
+{
+  Out = &OS;
+  const llvm::MemoryBuffer *Buf = SrcManager.getBuffer(FID);
+  Lexer TheLexer(FID, Buf, SrcManager, LangOpts);
+  TheLexer.SetCommentRetentionState(true);
+
+  Token Tok;
+  TheLexer.LexFromRawLexer(Tok);
+  while (Tok.isNot(tok::eof)) {
+    const char *Start = SrcManager.getCharacterData(Tok.getLocation());
+    if (Tok.is(tok::hash) && Tok.isAtStartOfLine()) {
+      // The directive ends with the last token before the next line
+      const char *End = Start + Tok.getLength();
+      TheLexer.LexFromRawLexer(Tok);
+      while (Tok.isNot(tok::eof) && !Tok.isAtStartOfLine()) {
+        End = SrcManager.getCharacterData(Tok.getLocation()) +
+              Tok.getLength();
+        TheLexer.LexFromRawLexer(Tok);
+      }
+      emitDirective(StringRef(Start, End - Start));
+      continue;
+    }
+    emitToken(Tok.getKind(), StringRef(Start, Tok.getLength()));
+    TheLexer.LexFromRawLexer(Tok);
+  }
+  newLine();
+  Out = NULL;
+}
@@ -0,0 +1,92 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2012 The University of Utah
+// All rights reserved.
+//
+// This file is distributed under the University of Illinois Open Source
+// License.  See the file COPYING for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOURCE_FORMATTER_H
+#define SOURCE_FORMATTER_H
+
+#include "llvm/ADT/StringRef.h"
+#include "clang/Basic/SourceLocation.h"
+#include "clang/Basic/TokenKinds.h"
+
+namespace llvm {
+  class raw_ostream;
+}
+
+namespace clang {
+  class LangOptions;
+  class SourceManager;
+}
+
+// Prints a source with canonical formatting for --format. The tokens
+// are separated by a single space or none, depending only on the tokens
+// around it, and every statement goes on a line of its own, indented by
+// its brace depth. Preprocessor directives are copied verbatim to lines
+// of their own. Thus sources which differ only in their whitespace are
+// printed alike. The source is only lexed, so it doesn't have to parse.
+class SourceFormatter {
+
+public:
+
+  SourceFormatter(const clang::SourceManager &SM,
+                  const clang::LangOptions &LOpts);
+
+  void format(clang::FileID FID, llvm::raw_ostream &OS);
+
+private:
+
+  static const unsigned IndentWidth = 2;
+
+  static bool isWordLike(clang::tok::TokenKind Kind);
+
+  static bool isOperandEnd(clang::tok::TokenKind Kind, llvm::StringRef Text);
+
+  static bool isControlKeyword(llvm::StringRef Text);
+
+  static bool mayJoin(char Left, char Right);
+
+  bool needSpace(clang::tok::TokenKind Kind, llvm::StringRef Text);
+
+  bool staysOnLine(clang::tok::TokenKind Kind, llvm::StringRef Text);
+
+  void newLine(void);
+
+  void emitToken(clang::tok::TokenKind Kind, llvm::StringRef Text);
+
+  void emitDirective(llvm::StringRef Text);
+
+  const clang::SourceManager &SrcManager;
+
+  const clang::LangOptions &LangOpts;
+
+  llvm::raw_ostream *Out;
+
+  unsigned IndentLevel;
+
+  unsigned ParenDepth;
+
+  bool AtLineStart;
+
+  // Set after a }, which ends the line unless a ; or an else follows
+  bool PendingNewLine;
+
+  clang::tok::TokenKind PrevKind;
+
+  llvm::StringRef PrevText;
+
+  bool PrevIsUnary;
+
+  // Unimplemented
+  SourceFormatter(const SourceFormatter &);
+
+  void operator=(const SourceFormatter &);
+
+};
+
+#endif
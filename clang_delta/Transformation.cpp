@@ -14,6 +14,7 @@
 
 #include "Transformation.h"
 
+#include <algorithm>
 #include <sstream>
 
 #include "clang/AST/RecursiveASTVisitor.h"
@@ -22,6 +23,8 @@
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/ADT/SmallString.h"
 
+#include "PhaseTimer.h"
+
 using namespace clang;
 
 class TransNameQueryVisitor : public 
@@ -88,7 +91,7 @@ void Transformation::Initialize(ASTContext &context)
   SrcManager = &Context->getSourceManager();
   TheRewriter.setSourceMgr(Context->getSourceManager(), 
                            Context->getLangOpts());
-  RewriteHelper = RewriteUtils::GetInstance(&TheRewriter);
+  RewriteHelper = new RewriteUtils(&TheRewriter);
 }
 
 void Transformation::outputTransformedSource(llvm::raw_ostream &OutStream)
@@ -739,8 +742,105 @@ unsigned Transformation::getNumCtorWrittenInitializers(
   return Num;
 }
 
+// Without --to-counter, only the instance given by --counter is selected.
+bool Transformation::isInCounterRange(int Counter)
+{
+  if (ToCounter <= 0)
+    return (Counter == TransformationCounter);
+  return ((Counter >= TransformationCounter) && (Counter <= ToCounter));
+}
+
+// Used when applying several instances at once: an instance whose text
+// overlaps with the text of an instance removed earlier is skipped.
+bool Transformation::removeNonOverlappingText(SourceRange Range)
+{
+  int RangeSize = TheRewriter.getRangeSize(Range);
+  if (RangeSize == -1)
+    return false;
+
+  unsigned StartOffset = SrcManager->getFileOffset(Range.getBegin());
+  unsigned EndOffset = StartOffset + RangeSize;
+  for (OffsetRangeVector::iterator I = RemovedOffsetRanges.begin(),
+       E = RemovedOffsetRanges.end(); I != E; ++I) {
+    if ((StartOffset < (*I).second) && ((*I).first < EndOffset))
+      return false;
+  }
+
+  RemovedOffsetRanges.push_back(std::make_pair(StartOffset, EndOffset));
+  return !(TheRewriter.RemoveText(Range));
+}
+
+// Count one more instance. With --list-instances or --order=size, Range
+// is recorded as the text which the instance removes.
+void Transformation::addInstance(SourceRange Range)
+{
+  ValidInstanceNum++;
+  if (!ListInstances && !OrderBySize)
+    return;
+
+  Instances.push_back(TransformationInstance(ValidInstanceNum));
+  addInstanceRange(Range);
+}
+
+// Record one more range for the latest instance. Ranges which are not
+// in the main file don't change the source, so they are dropped.
+void Transformation::addInstanceRange(SourceRange Range)
+{
+  if (!ListInstances && !OrderBySize)
+    return;
+  TransAssert(!Instances.empty() && "No instance!");
+
+  SourceLocation StartLoc = Range.getBegin();
+  if (StartLoc.isInvalid() || 
+      (SrcManager->getFileID(StartLoc) != SrcManager->getMainFileID()))
+    return;
+
+  int RangeSize = TheRewriter.getRangeSize(Range);
+  if (RangeSize == -1)
+    return;
+
+  TransformationInstance &Instance = Instances.back();
+  unsigned StartOffset = SrcManager->getFileOffset(StartLoc);
+  Instance.Ranges.push_back(std::make_pair(StartOffset, 
+                                           StartOffset + RangeSize));
+  Instance.Bytes += RangeSize;
+}
+
+static bool RemovesMoreBytes(const TransformationInstance &I1,
+                             const TransformationInstance &I2)
+{
+  return (I1.Bytes > I2.Bytes);
+}
+
+// With --order=size, map TransformationCounter from the order by size
+// to the order of addInstance. Transformations call this after they
+// collected all instances and before they select the one to rewrite,
+// so that both happen on the same AST.
+void Transformation::mapCounterBySize(void)
+{
+  if (!OrderBySize || (TransformationCounter > ValidInstanceNum))
+    return;
+  TransAssert((static_cast<int>(Instances.size()) == ValidInstanceNum) &&
+              "Instances not recorded!");
+
+  TransformationInstanceVector SortedInstances = Instances;
+  std::stable_sort(SortedInstances.begin(), SortedInstances.end(),
+                   RemovesMoreBytes);
+  TransformationCounter = SortedInstances[TransformationCounter - 1].Counter;
+}
+
+// For --time-report, transformations call this when they are done with
+// the analysis and start to rewrite the source
+void Transformation::startRewritePhase(void)
+{
+  if (!TimeReport)
+    return;
+  TimeReport->stopPhase(PhaseTimer::PhaseAnalyze);
+  TimeReport->startPhase(PhaseTimer::PhaseRewrite);
+}
+
 Transformation::~Transformation(void)
 {
-  RewriteUtils::Finalize();
+  delete RewriteHelper;
 }
 
@@ -12,12 +12,16 @@
 #define TRANSFORMATION_H
 
 #include <string>
+#include <utility>
+#include <vector>
 #include <cstdlib>
 #include <cassert>
 #include "clang/AST/ASTConsumer.h"
 #include "clang/Rewrite/Core/Rewriter.h"
 #include "RewriteUtils.h"
 
+class PhaseTimer;
+
 namespace clang {
   class CompilerInstance;
   class ASTContext;
@@ -49,6 +53,30 @@ typedef enum {
   TransNoValidParamsError
 } TransformationError;
 
+// What one instance of a transformation would change, for
+// --list-instances. Ranges are [begin, end) offsets in the main file.
+class TransformationInstance {
+
+public:
+
+  explicit TransformationInstance(int C)
+    : Counter(C),
+      Bytes(0)
+  { }
+
+  typedef llvm::SmallVector<std::pair<unsigned, unsigned>, 2> 
+    OffsetRangeVector;
+
+  int Counter;
+
+  // The estimated reduction of the size of the source
+  unsigned Bytes;
+
+  OffsetRangeVector Ranges;
+};
+
+typedef std::vector<TransformationInstance> TransformationInstanceVector;
+
 class Transformation : public clang::ASTConsumer {
 
 public:
@@ -56,13 +84,17 @@ public:
   Transformation(const char *TransName, const char *Desc)
     : Name(TransName),
       TransformationCounter(-1),
+      ToCounter(-1),
       ValidInstanceNum(0),
       QueryInstanceOnly(false),
+      ListInstances(false),
+      OrderBySize(false),
       Context(NULL),
       SrcManager(NULL),
       TransError(TransSuccess),
       DescriptionString(Desc),
-      RewriteHelper(NULL)
+      RewriteHelper(NULL),
+      TimeReport(NULL)
   {
     // Nothing to do
   }
@@ -77,10 +109,30 @@ public:
     TransformationCounter = Counter;
   }
 
+  void setToCounter(int Counter) {
+    ToCounter = Counter;
+  }
+
   void setQueryInstanceFlag(bool Flag) {
     QueryInstanceOnly = Flag;
   }
 
+  void setListInstancesFlag(bool Flag) {
+    ListInstances = Flag;
+  }
+
+  void setOrderBySizeFlag(bool Flag) {
+    OrderBySize = Flag;
+  }
+
+  void setTimeReport(PhaseTimer *T) {
+    TimeReport = T;
+  }
+
+  const TransformationInstanceVector &getInstances(void) {
+    return Instances;
+  }
+
   bool transSuccess(void) {
     return (TransError == TransSuccess);
   }
@@ -107,6 +159,25 @@ public:
     return false;
   }
 
+  // Transformations which never look into function bodies override
+  // this, so that the parser skips the bodies. Note that a function
+  // whose body was skipped doesn't count as a definition.
+  virtual bool skipFunctionBodies(void) {
+    return false;
+  }
+
+  // Transformations which can apply all instances from
+  // TransformationCounter to ToCounter in one run override this.
+  virtual bool supportMultipleRewrites(void) {
+    return false;
+  }
+
+  // Transformations which count all their instances with addInstance
+  // override this, so that --list-instances can list them.
+  virtual bool supportListInstances(void) {
+    return false;
+  }
+
 protected:
 
   typedef llvm::SmallVector<unsigned int, 10> IndexVector;
@@ -182,14 +253,32 @@ protected:
 
   unsigned getNumCtorWrittenInitializers(const clang::CXXConstructorDecl &Ctor);
 
+  bool isInCounterRange(int Counter);
+
+  bool removeNonOverlappingText(clang::SourceRange Range);
+
+  void addInstance(clang::SourceRange Range);
+
+  void addInstanceRange(clang::SourceRange Range);
+
+  void mapCounterBySize(void);
+
+  void startRewritePhase(void);
+
   const std::string Name;
 
   int TransformationCounter;
 
+  int ToCounter;
+
   int ValidInstanceNum;
 
   bool QueryInstanceOnly;
 
+  bool ListInstances;
+
+  bool OrderBySize;
+
   clang::ASTContext *Context;
 
   clang::SourceManager *SrcManager;
@@ -201,6 +290,16 @@ protected:
   std::string DescriptionString;
 
   RewriteUtils *RewriteHelper;
+
+private:
+
+  PhaseTimer *TimeReport;
+
+  typedef llvm::SmallVector<std::pair<unsigned, unsigned>, 10> OffsetRangeVector;
+
+  OffsetRangeVector RemovedOffsetRanges;
+
+  TransformationInstanceVector Instances;
 };
 
 class TransNameQueryVisitor;
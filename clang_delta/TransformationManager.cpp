@@ -15,10 +15,22 @@
 #include "TransformationManager.h"
 
 #include <sstream>
-
+#include <cerrno>
+#include <unistd.h>
+
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "clang/AST/ASTConsumer.h"
 #include "clang/Basic/Diagnostic.h"
+#include "clang/Basic/SourceManager.h"
 #include "clang/Basic/TargetInfo.h"
+#include "clang/Lex/Lexer.h"
 #include "clang/Lex/Preprocessor.h"
+#include "clang/Frontend/ASTUnit.h"
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Parse/ParseAST.h"
 
@@ -38,13 +50,15 @@
 #include "llvm/Config/config.h"
 
 #include "Transformation.h"
+#include "PhaseTimer.h"
+#include "ASTCache.h"
+#include "SourceFormatter.h"
 
 using namespace clang;
 
 TransformationManager* TransformationManager::Instance;
 
-std::map<std::string, Transformation *> *
-TransformationManager::TransformationsMapPtr;
+TransformationInfoMap *TransformationManager::TransformationsMapPtr;
 
 TransformationManager *TransformationManager::GetInstance(void)
 {
@@ -53,9 +67,6 @@ TransformationManager *TransformationManager::GetInstance(void)
 
   TransformationManager::Instance = new TransformationManager();
   assert(TransformationManager::Instance);
-
-  TransformationManager::Instance->TransformationsMap = 
-    *TransformationManager::TransformationsMapPtr;
   return TransformationManager::Instance;
 }
 
@@ -77,6 +88,105 @@ bool TransformationManager::isCLangOpt(void)
           .C99);
 }
 
+// Lang is given by --lang, otherwise the file extension decides.
+// Returns IK_None for unsupported files
+static InputKind GetInputKind(const std::string &FileName,
+                              TransformationLanguage Lang)
+{
+  if (Lang == TransLangC)
+    return IK_C;
+  if (Lang == TransLangCXX)
+    return IK_CXX;
+
+  InputKind IK = FrontendOptions::getInputKindForExtension(
+        StringRef(FileName).rsplit('.').second);
+  if ((IK == IK_C) || (IK == IK_PreprocessedC))
+    return IK_C;
+  if ((IK == IK_CXX) || (IK == IK_PreprocessedCXX))
+    return IK_CXX;
+  return IK_None;
+}
+
+// Set up everything except for the ASTConsumer and the main file.
+// The diagnostics are printed to stderr if DgConsumer is NULL.
+// Quoted #includes are also looked up in SrcDir, because the main file
+// may be a copy of the source elsewhere or a memory buffer.
+static CompilerInstance *CreateCompilerInstance(
+         InputKind IK,
+         DiagnosticConsumer *DgConsumer,
+         const std::vector<std::string> &IncludePaths,
+         const std::string &SrcDir)
+{
+  CompilerInstance *CI = new CompilerInstance();
+  assert(CI);
+  
+  CI->createDiagnostics(0, NULL, DgConsumer);
+
+  CompilerInvocation &Invocation = CI->getInvocation();
+  // ISSUE: for C++, it might cause some problems when building AST
+  // for a function which has a non-declared callee, e.g., 
+  // It results an empty AST for the caller. 
+  Invocation.setLangDefaults(CI->getLangOpts(), IK);
+
+  TargetOptions &TargetOpts = CI->getTargetOpts();
+  TargetOpts.Triple = LLVM_DEFAULT_TARGET_TRIPLE;
+  TargetInfo *Target = 
+    TargetInfo::CreateTargetInfo(CI->getDiagnostics(), TargetOpts);
+  CI->setTarget(Target);
+
+  HeaderSearchOptions &HSOpts = CI->getHeaderSearchOpts();
+  for (std::vector<std::string>::const_iterator I = IncludePaths.begin(),
+       E = IncludePaths.end(); I != E; ++I)
+    HSOpts.AddPath(*I, frontend::Angled, true, false, false);
+  if (!SrcDir.empty())
+    HSOpts.AddPath(SrcDir, frontend::Quoted, true, false, false);
+
+  CI->createFileManager();
+  CI->createSourceManager(CI->getFileManager());
+  CI->createPreprocessor();
+
+  DiagnosticConsumer &DgClient = CI->getDiagnosticClient();
+  DgClient.BeginSourceFile(CI->getLangOpts(), &CI->getPreprocessor());
+  CI->createASTContext();
+
+  Preprocessor &PP = CI->getPreprocessor();
+  PP.getBuiltinInfo().InitializeBuiltins(PP.getIdentifierTable(),
+                                         PP.getLangOpts());
+  return CI;
+}
+
+// Read everything from FD, which may be a pipe
+static llvm::MemoryBuffer *ReadFD(int FD, const std::string &Name)
+{
+  std::string Content;
+  char Buf[4096];
+  while (true) {
+    ssize_t Size = read(FD, Buf, sizeof(Buf));
+    if (Size == 0)
+      break;
+    if (Size < 0) {
+      if (errno == EINTR)
+        continue;
+      return NULL;
+    }
+    Content.append(Buf, Size);
+  }
+  return llvm::MemoryBuffer::getMemBufferCopy(Content, Name);
+}
+
+// The source is read from stdin for "-" or from --input-fd
+bool TransformationManager::isSrcFromFD(void)
+{
+  return ((InputFD >= 0) || (SrcFileName == "-"));
+}
+
+llvm::MemoryBuffer *TransformationManager::readSrcFromFD(void)
+{
+  if (InputFD >= 0)
+    return ReadFD(InputFD, SrcFileName.empty() ? "<input>" : SrcFileName);
+  return ReadFD(STDIN_FILENO, "<stdin>");
+}
+
 bool TransformationManager::initializeCompilerInstance(std::string &ErrorMsg)
 {
   if (ClangInstance) {
@@ -84,54 +194,296 @@ bool TransformationManager::initializeCompilerInstance(std::string &ErrorMsg)
     return false;
   }
 
-  ClangInstance = new CompilerInstance();
-  assert(ClangInstance);
-  
-  ClangInstance->createDiagnostics(0, NULL);
-
-  CompilerInvocation &Invocation = ClangInstance->getInvocation();
-  InputKind IK = FrontendOptions::getInputKindForExtension(
-        StringRef(SrcFileName).rsplit('.').second);
-  if ((IK == IK_C) || (IK == IK_PreprocessedC)) {
-    Invocation.setLangDefaults(ClangInstance->getLangOpts(), IK_C);
+  InputKind IK = GetInputKind(SrcFileName, SrcLang);
+  if (IK == IK_None) {
+    ErrorMsg = "Unsupported file type!";
+    return false;
   }
-  else if ((IK == IK_CXX) || (IK == IK_PreprocessedCXX)) {
-    // ISSUE: it might cause some problems when building AST
-    // for a function which has a non-declared callee, e.g., 
-    // It results an empty AST for the caller. 
-    Invocation.setLangDefaults(ClangInstance->getLangOpts(), IK_CXX);
+
+  if (TimeReport)
+    TimeReport->startPhase(PhaseTimer::PhaseInitCompiler);
+
+  ClangInstance = CreateCompilerInstance(IK, NULL, IncludePaths, getSrcDir());
+
+  assert(CurrentTransformationImpl && "Bad transformation instance!");
+  setConsumer();
+
+  if (isSrcFromFD()) {
+    llvm::MemoryBuffer *Buf = readSrcFromFD();
+    if (!Buf) {
+      ErrorMsg = "Cannot read source!";
+      return false;
+    }
+    ClangInstance->getSourceManager().createMainFileIDForMemBuffer(Buf);
   }
   else {
+    // With an AST cache, the cached copy of the source is parsed
+    std::string MainFileName = SrcFileName;
+    if (TheASTCache && setUpASTCache())
+      MainFileName = TheASTCache->getSrcPath();
+    if (!ClangInstance->InitializeSourceManager(
+           FrontendInputFile(MainFileName, IK))) {
+      ErrorMsg = "Cannot open source file!";
+      return false;
+    }
+  }
+
+  if (TimeReport)
+    TimeReport->stopPhase(PhaseTimer::PhaseInitCompiler);
+  return true;
+}
+
+// The absolute directory of the source file, or the current directory
+// for a source from stdin or a file descriptor
+std::string TransformationManager::getSrcDir(void)
+{
+  llvm::SmallString<256> SrcDir;
+  if (!isSrcFromFD())
+    SrcDir = llvm::sys::path::parent_path(SrcFileName);
+  llvm::sys::fs::make_absolute(SrcDir);
+  return SrcDir.str();
+}
+
+// The absolute include paths which Text is parsed with, i.e., the
+// include paths and, if Text has any quoted #include, the directory
+// of the source file
+void TransformationManager::getCachePaths(llvm::StringRef Text,
+                                          std::vector<std::string> &Paths)
+{
+  if (Text.find('"') != StringRef::npos)
+    Paths.push_back(getSrcDir());
+  for (std::vector<std::string>::iterator I = IncludePaths.begin(),
+       E = IncludePaths.end(); I != E; ++I) {
+    llvm::SmallString<256> Path(*I);
+    llvm::sys::fs::make_absolute(Path);
+    Paths.push_back(Path.str());
+  }
+}
+
+// Everything besides the text itself which a cached AST or preamble
+// depends on: the language and the include paths
+std::string TransformationManager::getCacheKey(
+              const std::vector<std::string> &Paths)
+{
+  std::stringstream KeySS;
+  KeySS << GetInputKind(SrcFileName, SrcLang) << "\n";
+  for (std::vector<std::string>::const_iterator I = Paths.begin(),
+       E = Paths.end(); I != E; ++I)
+    KeySS << (*I) << "\n";
+  return KeySS.str();
+}
+
+// Put a copy of the source into the AST cache. If the cache has no AST
+// for it yet, the AST is written to the cache while it is parsed.
+// Sources with a preamble use a cached preamble instead, which is less
+// specific to the source and mostly takes up the whole AST anyway.
+bool TransformationManager::setUpASTCache(void)
+{
+  OwningPtr<llvm::MemoryBuffer> Buf;
+  if (llvm::MemoryBuffer::getFile(SrcFileName, Buf))
+    return false;
+  if (getPreambleSize(Buf.get()))
+    return false;
+
+  std::vector<std::string> Paths;
+  getCachePaths(Buf->getBuffer(), Paths);
+  InputKind IK = GetInputKind(SrcFileName, SrcLang);
+  if (!TheASTCache->addSource(Buf->getBuffer(), getCacheKey(Paths),
+                              (IK == IK_CXX) ? ".cpp" : ".c"))
+    return false;
+
+  // Don't cache an AST without function bodies
+  UseASTCache = true;
+  if (!TheASTCache->hasAST() && 
+      !CurrentTransformationImpl->skipFunctionBodies())
+    ClangInstance->setASTConsumer(
+      TheASTCache->createASTWriter(*ClangInstance,
+                                   ClangInstance->takeASTConsumer()));
+  return true;
+}
+
+// The leading comments and preprocessor directives of Buf, i.e., the
+// part of the source which a precompiled preamble can stand for
+unsigned TransformationManager::getPreambleSize(const llvm::MemoryBuffer *Buf)
+{
+  return Lexer::ComputePreamble(Buf, ClangInstance->getLangOpts()).first;
+}
+
+// Build the PCH of the preamble from the copy of its text in the cache
+bool TransformationManager::buildPreamble(
+       const std::vector<std::string> &Paths)
+{
+  InputKind IK = GetInputKind(SrcFileName, SrcLang);
+  CompilerInstance *CI = 
+    CreateCompilerInstance(IK, new IgnoringDiagConsumer(), Paths, getSrcDir());
+
+  bool RV = false;
+  if (CI->InitializeSourceManager(
+        FrontendInputFile(TheASTCache->getPreambleSrcPath(), IK))) {
+    ASTConsumer *Writer = TheASTCache->createPreambleWriter(*CI);
+    if (Writer) {
+      CI->setASTConsumer(Writer);
+      CI->createSema(TU_Prefix, 0);
+      ParseAST(CI->getSema());
+      CI->getDiagnosticClient().EndSourceFile();
+      TheASTCache->commitAST();
+      RV = TheASTCache->hasPreamblePCH();
+    }
+  }
+  delete CI;
+  return RV;
+}
+
+// Let the preprocessor skip the preamble of the main file and load the
+// declarations and macros of the preamble from its PCH in the cache.
+// The PCH is built upon the first use of the preamble. It depends on
+// the include paths, and on the directory of the source file if it
+// has any quoted #include. Upon any failure, the whole main file is
+// parsed.
+void TransformationManager::setUpPreamble(void)
+{
+  SourceManager &SrcManager = ClangInstance->getSourceManager();
+  const llvm::MemoryBuffer *MainBuf = 
+    SrcManager.getBuffer(SrcManager.getMainFileID());
+  std::pair<unsigned, bool> Preamble = 
+    Lexer::ComputePreamble(MainBuf, ClangInstance->getLangOpts());
+  if (!Preamble.first)
+    return;
+
+  StringRef PreambleText(MainBuf->getBufferStart(), Preamble.first);
+  std::vector<std::string> Paths;
+  getCachePaths(PreambleText, Paths);
+
+  InputKind IK = GetInputKind(SrcFileName, SrcLang);
+  if (!TheASTCache->addPreamble(PreambleText, getCacheKey(Paths),
+                                (IK == IK_CXX) ? ".cpp" : ".c"))
+    return;
+  if (!TheASTCache->hasPreamblePCH() && !buildPreamble(Paths))
+    return;
+
+  PreprocessorOptions &PPOpts = ClangInstance->getPreprocessorOpts();
+  PPOpts.PrecompiledPreambleBytes = Preamble;
+  PPOpts.DisablePCHValidation = true;
+  ClangInstance->createPCHExternalASTSource(
+    TheASTCache->getPreamblePCHPath(), true, false, 0);
+  if (!ClangInstance->getASTContext().getExternalSource()) {
+    PPOpts.PrecompiledPreambleBytes = std::make_pair(0U, true);
+    return;
+  }
+  ClangInstance->getPreprocessor().setSkipMainFilePreamble(Preamble.first,
+                                                           Preamble.second);
+}
+
+// The first step replays the cached AST instead of parsing if it can.
+// Upon any failure of loading the AST, the source is parsed as usual.
+void TransformationManager::parseAST(unsigned Step)
+{
+  bool FirstStepCached = (UseASTCache && (Step == 0));
+  if (FirstStepCached && !TheASTCache->isWritingAST()) {
+    CachedAST = TheASTCache->loadAST(*ClangInstance);
+    if (CachedAST) {
+      ASTCache::replayAST(CachedAST, &ClangInstance->getASTConsumer());
+      return;
+    }
+  }
+
+  // A chained AST on top of the preamble is not supported
+  if (TheASTCache && !TheASTCache->isWritingAST())
+    setUpPreamble();
+
+  ClangInstance->createSema(TU_Complete, 0);
+  ParseAST(ClangInstance->getSema(), false,
+           CurrentTransformationImpl->skipFunctionBodies());
+
+  if (FirstStepCached)
+    TheASTCache->commitAST();
+}
+
+// Parse Buf as the main file with a fresh CompilerInstance, set up the
+// same way as the one of the transformation, and return true if there
+// is no error. Buf is owned by the SourceManager afterwards.
+bool TransformationManager::checkSyntax(llvm::MemoryBuffer *Buf)
+{
+  CompilerInstance *CI = 
+    CreateCompilerInstance(GetInputKind(SrcFileName, SrcLang), 
+                           new IgnoringDiagConsumer(), IncludePaths,
+                           getSrcDir());
+  CI->setASTConsumer(new ASTConsumer());
+  CI->getSourceManager().createMainFileIDForMemBuffer(Buf);
+  CI->createSema(TU_Complete, 0);
+
+  ParseAST(CI->getSema());
+
+  CI->getDiagnosticClient().EndSourceFile();
+  bool RV = !CI->getDiagnostics().hasErrorOccurred();
+  delete CI;
+  return RV;
+}
+
+bool TransformationManager::checkSrcSyntax(std::string &ErrorMsg)
+{
+  if (GetInputKind(SrcFileName, SrcLang) == IK_None) {
     ErrorMsg = "Unsupported file type!";
     return false;
   }
 
-  TargetOptions &TargetOpts = ClangInstance->getTargetOpts();
-  TargetOpts.Triple = LLVM_DEFAULT_TARGET_TRIPLE;
-  TargetInfo *Target = 
-    TargetInfo::CreateTargetInfo(ClangInstance->getDiagnostics(),
-                                 TargetOpts);
-  ClangInstance->setTarget(Target);
-  ClangInstance->createFileManager();
-  ClangInstance->createSourceManager(ClangInstance->getFileManager());
-  ClangInstance->createPreprocessor();
-
-  DiagnosticConsumer &DgClient = ClangInstance->getDiagnosticClient();
-  DgClient.BeginSourceFile(ClangInstance->getLangOpts(),
-                           &ClangInstance->getPreprocessor());
-  ClangInstance->createASTContext();
+  OwningPtr<llvm::MemoryBuffer> Buf;
+  if (isSrcFromFD()) {
+    Buf.reset(readSrcFromFD());
+    if (!Buf) {
+      ErrorMsg = "Cannot read source!";
+      return false;
+    }
+  }
+  else if (llvm::MemoryBuffer::getFile(SrcFileName, Buf)) {
+    ErrorMsg = "Cannot open source file!";
+    return false;
+  }
 
-  assert(CurrentTransformationImpl && "Bad transformation instance!");
-  ClangInstance->setASTConsumer(CurrentTransformationImpl);
-  Preprocessor &PP = ClangInstance->getPreprocessor();
-  PP.getBuiltinInfo().InitializeBuiltins(PP.getIdentifierTable(),
-                                         PP.getLangOpts());
+  if (!checkSyntax(Buf.take())) {
+    SyntaxError = true;
+    ErrorMsg = "The source has syntax errors!";
+    return false;
+  }
+  return true;
+}
+
+// Print the source with canonical formatting. The CompilerInstance
+// only provides the SourceManager and the LangOptions for the lexer.
+bool TransformationManager::formatSrc(std::string &ErrorMsg)
+{
+  InputKind IK = GetInputKind(SrcFileName, SrcLang);
+  if (IK == IK_None) {
+    ErrorMsg = "Unsupported file type!";
+    return false;
+  }
 
-  if (!ClangInstance->InitializeSourceManager(FrontendInputFile(SrcFileName, IK))) {
+  OwningPtr<llvm::MemoryBuffer> Buf;
+  if (isSrcFromFD()) {
+    Buf.reset(readSrcFromFD());
+    if (!Buf) {
+      ErrorMsg = "Cannot read source!";
+      return false;
+    }
+  }
+  else if (llvm::MemoryBuffer::getFile(SrcFileName, Buf)) {
     ErrorMsg = "Cannot open source file!";
     return false;
   }
 
+  CompilerInstance *CI = 
+    CreateCompilerInstance(IK, new IgnoringDiagConsumer(), IncludePaths,
+                           getSrcDir());
+  FileID FID = 
+    CI->getSourceManager().createMainFileIDForMemBuffer(Buf.take());
+
+  llvm::raw_ostream *OutStream = getOutStream();
+  SourceFormatter Formatter(CI->getSourceManager(), CI->getLangOpts());
+  Formatter.format(FID, *OutStream);
+  OutStream->flush();
+  closeOutStream(OutStream);
+
+  delete CI;
   return true;
 }
 
@@ -139,25 +491,31 @@ void TransformationManager::Finalize(void)
 {
   assert(TransformationManager::Instance);
   
-  std::map<std::string, Transformation *>::iterator I, E;
-  for (I = Instance->TransformationsMap.begin(), 
-       E = Instance->TransformationsMap.end();
-       I != E; ++I) {
-    // CurrentTransformationImpl will be freed by ClangInstance
-    if ((*I).second != Instance->CurrentTransformationImpl)
-      delete (*I).second;
-  }
   if (Instance->TransformationsMapPtr)
     delete Instance->TransformationsMapPtr;
 
+  // Once ClangInstance exists, it owns CurrentTransformationImpl
+  if (!Instance->ClangInstance)
+    delete Instance->CurrentTransformationImpl;
+
   delete Instance->ClangInstance;
 
+  // The transformation may refer to the cached AST until it's gone
+  delete Instance->CachedAST;
+
+  delete Instance->TheASTCache;
+
+  delete Instance->TimeReport;
+
   delete Instance;
   Instance = NULL;
 }
 
 llvm::raw_ostream *TransformationManager::getOutStream(void)
 {
+  if (OutputFD >= 0)
+    return new llvm::raw_fd_ostream(OutputFD, true);
+
   if (OutputFileName.empty())
     return &(llvm::outs());
 
@@ -170,44 +528,157 @@ llvm::raw_ostream *TransformationManager::getOutStream(void)
 
 void TransformationManager::closeOutStream(llvm::raw_ostream *OutStream)
 {
-  if (!OutputFileName.empty())
+  if (OutStream != &(llvm::outs()))
     delete OutStream;
 }
 
-bool TransformationManager::doTransformation(std::string &ErrorMsg)
+static void GetMainFileSource(CompilerInstance *CI, std::string &Source)
 {
-  ErrorMsg = "";
+  SourceManager &SrcManager = CI->getSourceManager();
+  const llvm::MemoryBuffer *MainBuf = 
+    SrcManager.getBuffer(SrcManager.getMainFileID());
+  TransAssert(MainBuf && "Empty MainBuf!");
+  Source.assign(MainBuf->getBufferStart(), MainBuf->getBufferEnd());
+}
 
-  ClangInstance->createSema(TU_Complete, 0);
-  ClangInstance->getDiagnostics().setSuppressAllDiagnostics(true);
+void TransformationManager::setConsumer(void)
+{
+  CurrentTransformationImpl->setTimeReport(TimeReport);
+  if (TimeReport)
+    ClangInstance->setASTConsumer(
+      TimeReport->wrapConsumer(CurrentTransformationImpl));
+  else
+    ClangInstance->setASTConsumer(CurrentTransformationImpl);
+}
 
-  CurrentTransformationImpl->setQueryInstanceFlag(QueryInstanceOnly);
-  CurrentTransformationImpl->setTransformationCounter(TransformationCounter);
+// Set up a new CompilerInstance which runs the transformation of the
+// given step of the chain on Source, the output of the previous step.
+void TransformationManager::initializeNextStep(unsigned Step,
+                                               const std::string &Source)
+{
+  if (TimeReport)
+    TimeReport->startPhase(PhaseTimer::PhaseInitCompiler);
+
+  // ClangInstance frees the transformation of the previous step
+  delete ClangInstance;
+  CurrentTransformationImpl = NULL;
+  createTransformation(TransformationNames[Step]);
+
+  ClangInstance = 
+    CreateCompilerInstance(GetInputKind(SrcFileName, SrcLang), NULL,
+                           IncludePaths, getSrcDir());
+  setConsumer();
+  ClangInstance->getSourceManager().createMainFileIDForMemBuffer(
+    llvm::MemoryBuffer::getMemBufferCopy(Source, SrcFileName));
+
+  if (TimeReport)
+    TimeReport->stopPhase(PhaseTimer::PhaseInitCompiler);
+}
 
-  ParseAST(ClangInstance->getSema());
+int TransformationManager::getStepCounter(unsigned Step)
+{
+  if (TransformationCounters.empty())
+    return -1;
+  if (TransformationCounters.size() == 1)
+    return TransformationCounters[0];
+  return TransformationCounters[Step];
+}
 
-  ClangInstance->getDiagnosticClient().EndSourceFile();
+bool TransformationManager::doTransformation(std::string &ErrorMsg)
+{
+  ErrorMsg = "";
 
-  if (QueryInstanceOnly) {
-    return true;
+  // Each step of a chain works on the output of the previous step.
+  // A step which cannot transform its input passes it on unchanged.
+  std::string Source;
+  bool Transformed = false;
+  bool InternalError = false;
+  for (unsigned Step = 0; Step < TransformationNames.size(); ++Step) {
+    if (Step > 0)
+      initializeNextStep(Step, Source);
+
+    // Don't parse the source at all if the transformation cannot have
+    // any instance for its language
+    if (!isApplicable()) {
+      if (QueryInstanceOnly)
+        return true;
+      ErrorMsg = "The transformation doesn't support this language!";
+      GetMainFileSource(ClangInstance, Source);
+      continue;
+    }
+
+    ClangInstance->getDiagnostics().setSuppressAllDiagnostics(true);
+
+    CurrentTransformationImpl->setQueryInstanceFlag(QueryInstanceOnly);
+    CurrentTransformationImpl->setListInstancesFlag(ListInstances);
+    CurrentTransformationImpl->setOrderBySizeFlag(OrderBySize);
+    CurrentTransformationImpl->setTransformationCounter(getStepCounter(Step));
+    CurrentTransformationImpl->setToCounter(ToCounter);
+
+    if (TimeReport)
+      TimeReport->startPhase(PhaseTimer::PhaseParse);
+
+    parseAST(Step);
+
+    ClangInstance->getDiagnosticClient().EndSourceFile();
+
+    if (QueryInstanceOnly) {
+      return true;
+    }
+
+    if (CurrentTransformationImpl->transSuccess()) {
+      if (TimeReport)
+        TimeReport->startPhase(PhaseTimer::PhaseRewrite);
+      Source.clear();
+      llvm::raw_string_ostream SourceStream(Source);
+      CurrentTransformationImpl->outputTransformedSource(SourceStream);
+      SourceStream.flush();
+      if (TimeReport)
+        TimeReport->stopPhase(PhaseTimer::PhaseRewrite);
+      Transformed = true;
+      continue;
+    }
+
+    if (CurrentTransformationImpl->transInternalError())
+      InternalError = true;
+    else
+      CurrentTransformationImpl->getTransErrorMsg(ErrorMsg);
+    GetMainFileSource(ClangInstance, Source);
   }
 
-  llvm::raw_ostream *OutStream = getOutStream();
-  bool RV;
-  if (CurrentTransformationImpl->transSuccess()) {
-    CurrentTransformationImpl->outputTransformedSource(*OutStream);
-    RV = true;
-  }
-  else if (CurrentTransformationImpl->transInternalError()) {
-    CurrentTransformationImpl->outputOriginalSource(*OutStream);
-    RV = true;
-  }
-  else {
-    CurrentTransformationImpl->getTransErrorMsg(ErrorMsg);
-    RV = false;
+  // The original source is the output upon an internal error
+  if (!Transformed && !InternalError)
+    return false;
+  ErrorMsg = "";
+
+  // Don't output a variant which cannot be interesting
+  if (CheckSyntax && Transformed) {
+    if (TimeReport)
+      TimeReport->startPhase(PhaseTimer::PhaseCheckSyntax);
+
+    bool Valid = checkSyntax(
+      llvm::MemoryBuffer::getMemBufferCopy(Source, SrcFileName));
+
+    if (TimeReport)
+      TimeReport->stopPhase(PhaseTimer::PhaseCheckSyntax);
+    if (!Valid) {
+      SyntaxError = true;
+      ErrorMsg = "The transformed source has syntax errors!";
+      return false;
+    }
   }
+
+  if (TimeReport)
+    TimeReport->startPhase(PhaseTimer::PhaseOutput);
+
+  llvm::raw_ostream *OutStream = getOutStream();
+  *OutStream << Source;
+  OutStream->flush();
   closeOutStream(OutStream);
-  return RV;
+
+  if (TimeReport)
+    TimeReport->stopPhase(PhaseTimer::PhaseOutput);
+  return true;
 }
 
 bool TransformationManager::verify(std::string &ErrorMsg)
@@ -217,49 +688,150 @@ bool TransformationManager::verify(std::string &ErrorMsg)
     return false;
   }
 
-  if ((TransformationCounter <= 0) && 
-      !CurrentTransformationImpl->skipCounter()) {
-    ErrorMsg = "Invalid transformation counter!";
+  unsigned NumSteps = TransformationNames.size();
+  if (NumSteps > 1) {
+    if (QueryInstanceOnly) {
+      ErrorMsg = "Cannot query instances of a chain of transformations!";
+      return false;
+    }
+    if (ToCounter > 0) {
+      ErrorMsg = "A chain of transformations doesn't support --to-counter!";
+      return false;
+    }
+    if (OrderBySize) {
+      ErrorMsg = "A chain of transformations doesn't support --order=size!";
+      return false;
+    }
+  }
+
+  if (ListInstances && !CurrentTransformationImpl->supportListInstances()) {
+    ErrorMsg = "The transformation doesn't support --list-instances!";
+    return false;
+  }
+
+  if (OrderBySize && !CurrentTransformationImpl->supportListInstances()) {
+    ErrorMsg = "The transformation doesn't support --order=size!";
     return false;
   }
 
+  if (OrderBySize && (ToCounter > 0)) {
+    ErrorMsg = "--order=size doesn't support --to-counter!";
+    return false;
+  }
+
+  if ((TransformationCounters.size() > 1) && 
+      (TransformationCounters.size() != NumSteps)) {
+    ErrorMsg = "The number of counters doesn't match the transformations!";
+    return false;
+  }
+
+  for (unsigned Step = 0; Step < NumSteps; ++Step) {
+    if ((getStepCounter(Step) <= 0) && 
+        ((NumSteps > 1) || !CurrentTransformationImpl->skipCounter())) {
+      ErrorMsg = "Invalid transformation counter!";
+      return false;
+    }
+  }
+
+  if (ToCounter > 0) {
+    if (!CurrentTransformationImpl->supportMultipleRewrites()) {
+      ErrorMsg = "The transformation doesn't support --to-counter!";
+      return false;
+    }
+    if (ToCounter < getStepCounter(0)) {
+      ErrorMsg = "to-counter value cannot be smaller than counter value!";
+      return false;
+    }
+  }
+
   return true;
 }
 
+void TransformationManager::createTransformation(const std::string &Trans)
+{
+  TransformationInfoMap::iterator I = TransformationsMapPtr->find(Trans);
+  assert((I != TransformationsMapPtr->end()) && "Unknown transformation!");
+
+  delete CurrentTransformationImpl;
+  const TransformationInfo &Info = (*I).second;
+  CurrentTransformationImpl = 
+    Info.Factory((*I).first.c_str(), Info.Description);
+  assert(CurrentTransformationImpl && "Fail to create TransformationClass");
+  CurrentTransformationLang = Info.Lang;
+}
+
+// Trans is either one transformation name or a comma-separated chain of
+// them. Only the transformation of the first step is created here.
+int TransformationManager::setTransformation(const std::string &Trans)
+{
+  llvm::SmallVector<StringRef, 8> Names;
+  StringRef(Trans).split(Names, ",");
+
+  TransformationNames.clear();
+  for (unsigned I = 0; I < Names.size(); ++I) {
+    std::string Name = Names[I].str();
+    if (TransformationsMapPtr->find(Name) == TransformationsMapPtr->end())
+      return -1;
+    TransformationNames.push_back(Name);
+  }
+
+  createTransformation(TransformationNames[0]);
+  return 0;
+}
+
+bool TransformationManager::isApplicable(void)
+{
+  switch (CurrentTransformationLang) {
+  case TransLangC:
+    return !isCXXLangOpt();
+  case TransLangCXX:
+    return isCXXLangOpt();
+  default:
+    return true;
+  }
+}
+
 void TransformationManager::registerTransformation(
        const char *TransName, 
-       Transformation *TransImpl)
+       const char *Desc,
+       TransformationLanguage Lang,
+       TransformationFactory Factory)
 {
   if (!TransformationManager::TransformationsMapPtr) {
     TransformationManager::TransformationsMapPtr = 
-      new std::map<std::string, Transformation *>();
+      new TransformationInfoMap();
   }
 
-  assert((TransImpl != NULL) && "NULL Transformation!");
+  assert((Factory != NULL) && "NULL TransformationFactory!");
   assert((TransformationManager::TransformationsMapPtr->find(TransName) == 
           TransformationManager::TransformationsMapPtr->end()) &&
          "Duplicated transformation!");
-  (*TransformationManager::TransformationsMapPtr)[TransName] = TransImpl;
+  (*TransformationManager::TransformationsMapPtr)[TransName] = 
+    TransformationInfo(Factory, Desc, Lang);
 }
 
 void TransformationManager::printTransformations(void)
 {
   llvm::outs() << "Registered Transformations:\n";
 
-  std::map<std::string, Transformation *>::iterator I, E;
-  for (I = TransformationsMap.begin(), 
-       E = TransformationsMap.end();
+  TransformationInfoMap::iterator I, E;
+  for (I = TransformationsMapPtr->begin(), 
+       E = TransformationsMapPtr->end();
        I != E; ++I) {
     llvm::outs() << "  [" << (*I).first << "]: "; 
-    llvm::outs() << (*I).second->getDescription() << "\n";
+    if ((*I).second.Lang == TransLangC)
+      llvm::outs() << "(C only) ";
+    else if ((*I).second.Lang == TransLangCXX)
+      llvm::outs() << "(C++ only) ";
+    llvm::outs() << (*I).second.Description << "\n";
   }
 }
 
 void TransformationManager::printTransformationNames(void)
 {
-  std::map<std::string, Transformation *>::iterator I, E;
-  for (I = TransformationsMap.begin(), 
-       E = TransformationsMap.end();
+  TransformationInfoMap::iterator I, E;
+  for (I = TransformationsMapPtr->begin(), 
+       E = TransformationsMapPtr->end();
        I != E; ++I) {
     llvm::outs() << (*I).first << "\n";
   }
@@ -273,13 +845,87 @@ void TransformationManager::outputNumTransformationInstances(void)
                << NumInstances << "\n";
 }
 
+// Print the instances as JSON, e.g.,
+//   { "transformation": "remove-unused-function",
+//     "num-instances": 1,
+//     "instances": [
+//       { "counter": 1, "bytes": 30,
+//         "ranges": [ { "begin": 12, "end": 42, "line": 2, "column": 1 } ] }
+//     ] }
+void TransformationManager::outputInstanceList(void)
+{
+  SourceManager &SrcManager = ClangInstance->getSourceManager();
+  FileID MainFileID = SrcManager.getMainFileID();
+  const TransformationInstanceVector &Instances = 
+    CurrentTransformationImpl->getInstances();
+
+  llvm::raw_ostream &OS = llvm::outs();
+  OS << "{\n";
+  OS << "  \"transformation\": \"" << TransformationNames[0] << "\",\n";
+  OS << "  \"num-instances\": " 
+     << CurrentTransformationImpl->getNumTransformationInstances() << ",\n";
+  OS << "  \"instances\": [";
+  for (TransformationInstanceVector::const_iterator I = Instances.begin(),
+       E = Instances.end(); I != E; ++I) {
+    OS << ((I == Instances.begin()) ? "\n" : ",\n");
+    OS << "    { \"counter\": " << (*I).Counter << ", "
+       << "\"bytes\": " << (*I).Bytes << ", \"ranges\": [";
+    for (TransformationInstance::OffsetRangeVector::const_iterator
+         RI = (*I).Ranges.begin(), RE = (*I).Ranges.end(); RI != RE; ++RI) {
+      unsigned Begin = (*RI).first;
+      OS << ((RI == (*I).Ranges.begin()) ? " " : ", ")
+         << "{ \"begin\": " << Begin << ", \"end\": " << (*RI).second
+         << ", \"line\": " << SrcManager.getLineNumber(MainFileID, Begin)
+         << ", \"column\": " << SrcManager.getColumnNumber(MainFileID, Begin)
+         << " }";
+    }
+    OS << " ] }";
+  }
+  OS << (Instances.empty() ? "]\n" : "\n  ]\n");
+  OS << "}\n";
+}
+
+void TransformationManager::setTimeReport(bool JSON)
+{
+  if (!TimeReport)
+    TimeReport = new PhaseTimer(JSON);
+}
+
+void TransformationManager::setCacheDir(const std::string &Dir)
+{
+  if (!TheASTCache)
+    TheASTCache = new ASTCache(Dir);
+}
+
+// The report goes to stderr, because the transformed source
+// may be written to stdout.
+void TransformationManager::outputTimeReport(void)
+{
+  if (TimeReport)
+    TimeReport->printReport(llvm::errs());
+}
+
 TransformationManager::TransformationManager(void)
   : CurrentTransformationImpl(NULL),
-    TransformationCounter(-1),
+    CurrentTransformationLang(TransLangAll),
+    ToCounter(-1),
     SrcFileName(""),
+    SrcLang(TransLangAll),
+    InputFD(-1),
+    OutputFD(-1),
     OutputFileName(""),
     ClangInstance(NULL),
-    QueryInstanceOnly(false)
+    QueryInstanceOnly(false),
+    ListInstances(false),
+    OrderBySize(false),
+    CheckSyntax(false),
+    CheckSyntaxOnly(false),
+    Format(false),
+    SyntaxError(false),
+    TimeReport(NULL),
+    TheASTCache(NULL),
+    CachedAST(NULL),
+    UseASTCache(false)
 {
   // Nothing to do
 }
@@ -13,15 +13,59 @@
 
 #include <string>
 #include <map>
+#include <vector>
 #include <cassert>
 
+#include "llvm/ADT/StringRef.h"
 #include "llvm/Support/raw_ostream.h"
 
 class Transformation;
+class PhaseTimer;
+class ASTCache;
+namespace llvm {
+  class MemoryBuffer;
+}
 namespace clang {
+  class ASTUnit;
   class CompilerInstance;
 }
 
+typedef enum {
+  TransLangAll = 0,
+  TransLangC,
+  TransLangCXX
+} TransformationLanguage;
+
+typedef Transformation *(*TransformationFactory)(const char *TransName,
+                                                 const char *Desc);
+
+// What the registry knows about a transformation without creating it
+class TransformationInfo {
+
+public:
+
+  TransformationInfo(void)
+    : Factory(NULL),
+      Description(NULL),
+      Lang(TransLangAll)
+  { }
+
+  TransformationInfo(TransformationFactory F, const char *Desc,
+                     TransformationLanguage L)
+    : Factory(F),
+      Description(Desc),
+      Lang(L)
+  { }
+
+  TransformationFactory Factory;
+
+  const char *Description;
+
+  TransformationLanguage Lang;
+};
+
+typedef std::map<std::string, TransformationInfo> TransformationInfoMap;
+
 class TransformationManager {
 
 public:
@@ -31,7 +75,9 @@ public:
   static void Finalize(void);
 
   static void registerTransformation(const char *TransName, 
-                                     Transformation *TransImpl);
+                                     const char *Desc,
+                                     TransformationLanguage Lang,
+                                     TransformationFactory Factory);
   
   static bool isCXXLangOpt(void);
 
@@ -41,16 +87,22 @@ public:
 
   bool verify(std::string &ErrorMsg);
 
-  int setTransformation(const std::string &Trans) {
-    if (TransformationsMap.find(Trans.c_str()) == TransformationsMap.end())
-      return -1;
-    CurrentTransformationImpl = TransformationsMap[Trans.c_str()];
-    return 0;
-  }
+  int setTransformation(const std::string &Trans);
 
   void setTransformationCounter(int Counter) {
     assert((Counter > 0) && "Bad Counter value!");
-    TransformationCounter = Counter;
+    TransformationCounters.clear();
+    TransformationCounters.push_back(Counter);
+  }
+
+  // For a chain of transformations, one counter per step
+  void addTransformationCounter(int Counter) {
+    assert((Counter > 0) && "Bad Counter value!");
+    TransformationCounters.push_back(Counter);
+  }
+
+  void setToCounter(int Counter) {
+    ToCounter = Counter;
   }
 
   void setSrcFileName(const std::string &FileName) {
@@ -62,6 +114,19 @@ public:
     OutputFileName = FileName;
   }
 
+  // Overrides the language given by the extension of the source file
+  void setSrcLang(TransformationLanguage Lang) {
+    SrcLang = Lang;
+  }
+
+  void setInputFD(int FD) {
+    InputFD = FD;
+  }
+
+  void setOutputFD(int FD) {
+    OutputFD = FD;
+  }
+
   void setQueryInstanceFlag(bool Flag) {
     QueryInstanceOnly = Flag;
   }
@@ -70,10 +135,64 @@ public:
     return QueryInstanceOnly;
   }
 
+  // Counters refer to the instances sorted by the number of bytes
+  // they remove, largest first
+  void setOrderBySizeFlag(bool Flag) {
+    OrderBySize = Flag;
+  }
+
+  void setListInstancesFlag(bool Flag) {
+    ListInstances = Flag;
+  }
+
+  bool getListInstancesFlag(void) {
+    return ListInstances;
+  }
+
+  void setCheckSyntaxFlag(bool Flag) {
+    CheckSyntax = Flag;
+  }
+
+  void setCheckSyntaxOnlyFlag(bool Flag) {
+    CheckSyntaxOnly = Flag;
+  }
+
+  bool getCheckSyntaxOnlyFlag(void) {
+    return CheckSyntaxOnly;
+  }
+
+  void setFormatFlag(bool Flag) {
+    Format = Flag;
+  }
+
+  bool getFormatFlag(void) {
+    return Format;
+  }
+
+  bool syntaxCheckFailed(void) {
+    return SyntaxError;
+  }
+
+  void setTimeReport(bool JSON);
+
+  void setCacheDir(const std::string &Dir);
+
+  void addIncludePath(const std::string &Path) {
+    IncludePaths.push_back(Path);
+  }
+
+  void outputTimeReport(void);
+
   bool initializeCompilerInstance(std::string &ErrorMsg);
 
+  bool checkSrcSyntax(std::string &ErrorMsg);
+
+  bool formatSrc(std::string &ErrorMsg);
+
   void outputNumTransformationInstances(void);
 
+  void outputInstanceList(void);
+
   void printTransformations();
 
   void printTransformationNames();
@@ -88,24 +207,90 @@ private:
 
   void closeOutStream(llvm::raw_ostream *OutStream);
 
-  static TransformationManager *Instance;
+  bool checkSyntax(llvm::MemoryBuffer *Buf);
+
+  bool isSrcFromFD(void);
+
+  llvm::MemoryBuffer *readSrcFromFD(void);
+
+  bool isApplicable(void);
 
-  static std::map<std::string, Transformation *> *TransformationsMapPtr;
+  void createTransformation(const std::string &Trans);
 
-  std::map<std::string, Transformation *> TransformationsMap;
+  void setConsumer(void);
+
+  void initializeNextStep(unsigned Step, const std::string &Source);
+
+  int getStepCounter(unsigned Step);
+
+  std::string getSrcDir(void);
+
+  void getCachePaths(llvm::StringRef Text, std::vector<std::string> &Paths);
+
+  std::string getCacheKey(const std::vector<std::string> &Paths);
+
+  bool setUpASTCache(void);
+
+  unsigned getPreambleSize(const llvm::MemoryBuffer *Buf);
+
+  void setUpPreamble(void);
+
+  bool buildPreamble(const std::vector<std::string> &Paths);
+
+  void parseAST(unsigned Step);
+
+  static TransformationManager *Instance;
+
+  static TransformationInfoMap *TransformationsMapPtr;
 
   Transformation *CurrentTransformationImpl;
 
-  int TransformationCounter;
+  TransformationLanguage CurrentTransformationLang;
+
+  std::vector<std::string> TransformationNames;
+
+  std::vector<int> TransformationCounters;
+
+  int ToCounter;
 
   std::string SrcFileName;
 
+  TransformationLanguage SrcLang;
+
+  int InputFD;
+
+  int OutputFD;
+
   std::string OutputFileName;
 
+  std::vector<std::string> IncludePaths;
+
   clang::CompilerInstance *ClangInstance;
 
   bool QueryInstanceOnly;
 
+  bool ListInstances;
+
+  bool OrderBySize;
+
+  bool CheckSyntax;
+
+  bool CheckSyntaxOnly;
+
+  bool Format;
+
+  bool SyntaxError;
+
+  PhaseTimer *TimeReport;
+
+  ASTCache *TheASTCache;
+
+  // The AST of the first step if it was loaded from TheASTCache
+  clang::ASTUnit *CachedAST;
+
+  // Whether the first step parses the cached copy of the source
+  bool UseASTCache;
+
   // Unimplemented
   TransformationManager(const TransformationManager &);
 
@@ -113,18 +298,23 @@ private:
 
 };
 
+// Only registers a factory, the transformation is created when it is
+// selected. Lang tells which languages the transformation applies to.
 template<typename TransformationClass>
 class RegisterTransformation {
 
 public:
-  RegisterTransformation(const char *TransName, const char *Desc) {
-    Transformation *TransImpl = new TransformationClass(TransName, Desc);
-    assert(TransImpl && "Fail to create TransformationClass");
- 
-    TransformationManager::registerTransformation(TransName, TransImpl);
+  RegisterTransformation(const char *TransName, const char *Desc,
+                         TransformationLanguage Lang = TransLangAll) {
+    TransformationManager::registerTransformation(TransName, Desc, Lang,
+                                                  create);
   }
 
 private:
+  static Transformation *create(const char *TransName, const char *Desc) {
+    return new TransformationClass(TransName, Desc);
+  }
+
   // Unimplemented
   RegisterTransformation(const RegisterTransformation &);
 
@@ -65,6 +65,7 @@ void UnifyFunctionDecl::HandleTranslationUnit(ASTContext &Ctx)
     return;
   }
 
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
 
   TransAssert(TheFunctionDecl && "NULL TheFunctionDecl!");
@@ -138,6 +138,7 @@ void UnionToStruct::HandleTranslationUnit(ASTContext &Ctx)
   rewriteRecordDecls();
   rewriteDeclarators();
 
+  startRewritePhase();
   Ctx.getDiagnostics().setSuppressAllDiagnostics(false);
 
   if (Ctx.getDiagnostics().hasErrorOccurred() ||
@@ -0,0 +1,241 @@
+## -*- mode: Perl -*-
+##
+## Copyright (c) 2012 The University of Utah
+## All rights reserved.
+##
+## This file is distributed under the University of Illinois Open Source
+## License.  See the file COPYING for details.
+
+###############################################################################
+
+# Declarative interestingness tests, which creduce runs itself instead of
+# starting a shell script. A checks file has one directive per line;
+# blank lines and lines starting with # are ignored:
+#
+#   timeout <seconds>       kill the command after this long (default: none)
+#   run <command> <args>    run a command, without a shell; arguments can be
+#                           quoted, and $FILE stands for the variant
+#   exit <code>|any         the exit code the last command must return
+#                           (default: 0)
+#   require <regex>         the combined stdout and stderr of the last
+#                           command must match the Perl regex
+#   forbid <regex>          ... must not match it
+#   require-stdout <regex>, require-stderr <regex>,
+#   forbid-stdout <regex>, forbid-stderr <regex>
+#                           the same for one of the output streams
+#
+# require and forbid before the first run apply to the variant itself.
+# The checks stop at the first command which fails them, so the cheapest
+# ones should come first.
+
+package creduce_checks;
+
+use strict;
+use warnings;
+
+use Exporter::Lite;
+use POSIX;
+use Text::ParseWords;
+
+our @EXPORT = qw(parse_checks run_checks $check_limits $check_signal
+                 $check_timed_out);
+
+# shell commands, e.g. ulimit calls, to run before each command
+our $check_limits = "";
+
+# the signal which killed the last command, or 0
+our $check_signal = 0;
+
+# set if the last command ran out of time
+our $check_timed_out = 0;
+
+my %streams = (
+    "" => "all",
+    "-stdout" => "stdout",
+    "-stderr" => "stderr",
+    );
+
+# all patterns of a kind as one regex, so that the output is scanned once;
+# the name of the capture group says which pattern matched
+sub compile_patterns ($) {
+    (my $pats) = @_;
+    return undef unless @{$pats};
+    my @alts = ();
+    for (my $i=0; $i<scalar(@{$pats}); $i++) {
+	push @alts, "(?<p$i>${$pats}[$i])";
+    }
+    my $re = join ('|', @alts);
+    return qr/$re/m;
+}
+
+sub finish_step ($) {
+    (my $step) = @_;
+    foreach my $stream (values %streams) {
+	my $req = ${$step}{"require"}{$stream};
+	${$step}{"require_re"}{$stream} = compile_patterns ($req);
+	${$step}{"forbid_re"}{$stream} =
+	    compile_patterns (${$step}{"forbid"}{$stream});
+    }
+}
+
+sub new_step ($) {
+    (my $argv) = @_;
+    my %step = ("argv" => $argv, "exit" => 0);
+    foreach my $stream (values %streams) {
+	$step{"require"}{$stream} = [];
+	$step{"forbid"}{$stream} = [];
+    }
+    return \%step;
+}
+
+# returns a reference to the parsed checks, or dies with a message
+sub parse_checks ($) {
+    (my $file) = @_;
+    my %checks = ("timeout" => 0, "input" => new_step (undef), "steps" => []);
+    my $step = $checks{"input"};
+
+    open INF, "<$file" or die "cannot open checks file '$file'\n";
+    while (my $line = <INF>) {
+	chomp $line;
+	next if ($line =~ /^\s*(#|$)/);
+	$line =~ s/^\s+//;
+	(my $directive, my $arg) = split (/\s+/, $line, 2);
+	$arg = "" unless defined($arg);
+	my $where = "$file:$.";
+	if ($directive eq "timeout") {
+	    die "$where: bad timeout '$arg'\n" unless ($arg =~ /^\d+$/);
+	    $checks{"timeout"} = $arg;
+	} elsif ($directive eq "run") {
+	    my @argv = Text::ParseWords::shellwords ($arg);
+	    die "$where: run needs a command\n" unless @argv;
+	    $step = new_step (\@argv);
+	    push @{$checks{"steps"}}, $step;
+	} elsif ($directive eq "exit") {
+	    die "$where: exit before run\n" unless defined(${$step}{"argv"});
+	    die "$where: bad exit code '$arg'\n" unless ($arg =~ /^(\d+|any)$/);
+	    ${$step}{"exit"} = $arg;
+	} elsif ($directive =~ /^(require|forbid)(|-stdout|-stderr)$/) {
+	    my $kind = $1;
+	    my $stream = $streams{$2};
+	    die "$where: $directive needs a regex\n" if ($arg eq "");
+	    die "$where: $directive before run\n"
+		if (!defined(${$step}{"argv"}) && ($stream ne "all"));
+	    eval { qr/$arg/ };
+	    die "$where: bad regex '$arg': $@" if $@;
+	    push @{${$step}{$kind}{$stream}}, $arg;
+	} else {
+	    die "$where: unknown directive '$directive'\n";
+	}
+    }
+    close INF;
+
+    finish_step ($checks{"input"});
+    foreach my $s (@{$checks{"steps"}}) {
+	finish_step ($s);
+    }
+    return \%checks;
+}
+
+sub match_step ($$$) {
+    (my $step, my $stream, my $text) = @_;
+
+    my $forbid = ${$step}{"forbid_re"}{$stream};
+    return 0 if (defined($forbid) && $text =~ $forbid);
+
+    my $require = ${$step}{"require_re"}{$stream};
+    return 1 unless defined($require);
+    my %found = ();
+    while ($text =~ /$require/g) {
+	foreach my $k (keys %+) {
+	    $found{$k} = 1;
+	}
+    }
+    # a pattern may only match where another one has matched first
+    my $pats = ${$step}{"require"}{$stream};
+    for (my $i=0; $i<scalar(@{$pats}); $i++) {
+	next if $found{"p$i"};
+	return 0 unless ($text =~ /${$pats}[$i]/m);
+    }
+    return 1;
+}
+
+sub slurp ($) {
+    (my $file) = @_;
+    open my $fh, "<", $file or return "";
+    local $/;
+    my $text = <$fh>;
+    close $fh;
+    return defined($text) ? $text : "";
+}
+
+# runs a command with its output in files in the current directory;
+# returns its exit code, or -1 if it didn't exit normally or timed out
+sub run_command ($$$) {
+    (my $argv, my $fn, my $timeout) = @_;
+    my @cmd = map { (my $arg = $_) =~ s/\$FILE/$fn/g; $arg } @{$argv};
+    # only a shell can set the limits
+    @cmd = ("/bin/sh", "-c", "$check_limits exec \"\$@\"", "sh", @cmd)
+	if ($check_limits ne "");
+
+    $check_signal = 0;
+    $check_timed_out = 0;
+    my $pid = fork();
+    die unless defined($pid);
+    if ($pid == 0) {
+	# in a group of its own, so that a timeout kills its children too
+	POSIX::setpgid (0, 0);
+	open STDIN, "</dev/null";
+	open STDOUT, ">check.out" or POSIX::_exit (127);
+	open STDERR, ">check.err" or POSIX::_exit (127);
+	exec { $cmd[0] } @cmd or POSIX::_exit (127);
+    }
+    POSIX::setpgid ($pid, $pid);
+
+    # creduce kills the process group of a test which is no longer needed;
+    # pass that on to the command's group
+    local $SIG{TERM} = sub {
+	kill ('KILL', -$pid);
+	POSIX::_exit (1);
+    };
+
+    my $status;
+    eval {
+	local $SIG{ALRM} = sub { die "timeout\n" };
+	alarm ($timeout);
+	waitpid ($pid, 0);
+	$status = $?;
+	alarm (0);
+    };
+    if (!defined($status)) {
+	kill ('KILL', -$pid);
+	waitpid ($pid, 0);
+	$check_timed_out = 1;
+	return -1;
+    }
+    if (WIFSIGNALED($status)) {
+	$check_signal = WTERMSIG($status);
+	return -1;
+    }
+    return WEXITSTATUS($status);
+}
+
+# returns true if the variant in $fn passes the checks
+sub run_checks ($$) {
+    (my $checks, my $fn) = @_;
+
+    return 0 unless match_step (${$checks}{"input"}, "all", slurp ($fn));
+
+    foreach my $step (@{${$checks}{"steps"}}) {
+	my $code = run_command (${$step}{"argv"}, $fn, ${$checks}{"timeout"});
+	return 0 if ($code < 0);
+	return 0 unless (${$step}{"exit"} eq "any" || $code == ${$step}{"exit"});
+	my $out = slurp ("check.out");
+	my $err = slurp ("check.err");
+	return 0 unless (match_step ($step, "stdout", $out) &&
+			 match_step ($step, "stderr", $err) &&
+			 match_step ($step, "all", $out.$err));
+    }
+    return 1;
+}
+
+1;
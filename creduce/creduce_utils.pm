@@ -14,11 +14,29 @@ use warnings;
 
 use Exporter::Lite;
 
-@EXPORT      = qw(read_file write_file $OK $STOP $VERBOSE
+@EXPORT      = qw(read_file write_file $OK $STOP $VERBOSE $CHECK_SYNTAX
+                  $AST_CACHE_DIR @CLANG_DELTA_ARGS @INCLUDE_PATHS @QUOTE_PATHS
                   $replace_cont replace_aux runit $matched);
 
 $VERBOSE = 0;
 
+# if set, variants are parsed by clang_delta before they are tested;
+# only enabled when the original file parses without errors
+$CHECK_SYNTAX = 0;
+
+# if set, clang_delta keeps the ASTs of the sources it parses in this
+# directory, so that the same source is parsed only once
+$AST_CACHE_DIR = "";
+
+# more arguments for every clang_delta run, e.g., the language and the
+# include paths when several files are reduced
+@CLANG_DELTA_ARGS = ();
+
+# the absolute -I directories given to creduce, and the directories of
+# the files being reduced, where their quoted #includes are found
+@INCLUDE_PATHS = ();
+@QUOTE_PATHS = ();
+
 $OK = 999999;
 $STOP = 111333;
 
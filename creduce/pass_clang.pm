@@ -15,8 +15,9 @@ use warnings;
 
 use POSIX;
 
+use File::Basename;
 use File::Copy;
-use File::Spec;
+use File::Temp;
 
 use creduce_config qw(bindir libexecdir);
 use creduce_regexes;
@@ -58,39 +59,137 @@ sub advance ($$$) {
     return \$index;
 }
 
+# exit status of clang_delta when --check-syntax rejects a variant
+my $SYNTAX_ERROR = 2;
+
+# removal transformations which can list their instances; these try
+# the instances which remove the most text first
+my %ORDER_BY_SIZE = map { $_ => 1 } qw(remove-unused-function
+                                       remove-unused-var
+                                       remove-unused-enum-member);
+
+# Run clang_delta on $cfile with the given counter arguments and
+# replace $cfile with the result.  Returns 1 on success, 0 when there
+# was nothing to transform (or clang_delta crashed), and -1 when the
+# syntax check rejected the transformed file.
+#
+# clang_delta's output is read through a pipe, without a shell, and
+# written over $cfile directly; there are no temporary files.
+sub run_clang_delta ($$$) {
+    (my $cfile, my $which, my $counters) = @_;
+    my @cmd = ($clang_delta, "--transformation=$which");
+    push @cmd, "--check-syntax" if $CHECK_SYNTAX;
+    push @cmd, "--cache-dir=$AST_CACHE_DIR" if $AST_CACHE_DIR;
+    push @cmd, @CLANG_DELTA_ARGS;
+    push @cmd, split (' ', $counters);
+    push @cmd, $cfile;
+
+    my $out = "";
+    if (open (my $pipe, "-|", @cmd)) {
+	local $/;
+	binmode $pipe;
+	$out = <$pipe>;
+	$out = "" unless defined($out);
+	close $pipe;
+    }
+    my $res = $? >> 8;
+    if ($? == 0) {
+	open (my $outf, ">", $cfile) or die;
+	binmode $outf;
+	print $outf $out;
+	close $outf;
+	return 1;
+    } elsif (!($? & 127) && $res == $SYNTAX_ERROR) {
+	return -1;
+    } elsif ($res == 255) {
+	return 0;
+    } else {
+	my ($suffix) = $cfile =~ /(\.[^.]+)$/;
+	$suffix = "" unless defined($suffix);
+	(my $crashfh, my $crashfile_path) = 
+	    File::Temp::tempfile ("clang_delta_crash_XXXXXX",
+				  DIR => $ORIG_DIR, SUFFIX => $suffix,
+				  UNLINK => 0);
+	close $crashfh;
+	my $crashfile = File::Basename::basename ($crashfile_path);
+	File::Copy::copy($cfile, $crashfile_path);
+	open TMPF, ">>$crashfile_path";
+	print TMPF "\n\n";
+	print TMPF "\/\/ this should reproduce the crash:\n";
+	print TMPF "\/\/ $clang_delta --transformation=$which $counters @CLANG_DELTA_ARGS $crashfile_path\n";
+	close TMPF;
+	print "\n\n=======================================\n\n";
+	print "OOPS: clang_delta crashed; please consider mailing\n";
+	print "${crashfile}\n";
+	print "to creduce-bugs\@flux.utah.edu and we will try to fix the bug\n";
+	print "please also let us know what version of C-Reduce you are using\n";
+	print "\n=======================================\n\n";
+	return 0;
+    }
+}
+
+sub query_instances ($$) {
+    (my $cfile, my $which) = @_;
+    my @cmd = ($clang_delta, "--query-instances=$which");
+    push @cmd, "--cache-dir=$AST_CACHE_DIR" if $AST_CACHE_DIR;
+    push @cmd, @CLANG_DELTA_ARGS;
+    push @cmd, $cfile;
+    open (my $pipe, "-|", @cmd)
+	or return 0;
+    local $/;
+    my $out = <$pipe>;
+    close $pipe;
+    return 0 unless ($? == 0 && defined($out));
+    return $1 if ($out =~ /Available transformation instances: (\d+)/);
+    return 0;
+}
+
+# Returns 1 if clang_delta can parse $cfile without errors
+sub check_syntax ($) {
+    (my $cfile) = @_;
+    my @cmd = ($clang_delta, "--check-syntax-only", @CLANG_DELTA_ARGS, $cfile);
+    my $pid = fork();
+    return 0 unless defined($pid);
+    if ($pid == 0) {
+	open STDOUT, ">/dev/null" or POSIX::_exit (1);
+	open STDERR, ">/dev/null" or POSIX::_exit (1);
+	exec { $cmd[0] } @cmd or POSIX::_exit (1);
+    }
+    waitpid ($pid, 0);
+    return ($? == 0);
+}
+
+# Replaces $cfile with its canonical formatting; returns 0 if clang_delta
+# fails
+sub format_file ($) {
+    (my $cfile) = @_;
+    my @cmd = ($clang_delta, "--format", @CLANG_DELTA_ARGS, $cfile);
+    open (my $pipe, "-|", @cmd)
+	or return 0;
+    local $/;
+    binmode $pipe;
+    my $out = <$pipe>;
+    close $pipe;
+    return 0 unless ($? == 0 && defined($out));
+    open (my $outf, ">", $cfile) or die;
+    binmode $outf;
+    print $outf $out;
+    close $outf;
+    return 1;
+}
+
 sub transform ($$$) {
     (my $cfile, my $which, my $state) = @_;
     my $index = ${$state};
-    my $tmpfile = POSIX::tmpnam();
-    my $cmd = "$clang_delta --transformation=$which --counter=$index $cfile";
-    my $res = runit ("$cmd > $tmpfile");
-    if ($res==0) {
-	system "mv $tmpfile $cfile";
-	return ($OK, \$index);
-    } else {
-	if ($res == -1) {
-	} else {
-	    my $crashfile = $tmpfile;
-	    $crashfile =~ s/\//_/g;
-	    my ($suffix) = $cfile =~ /(\.[^.]+)$/;
-	    $crashfile = "clang_delta_crash" . $crashfile . $suffix;
-	    my $crashfile_path = File::Spec->join($ORIG_DIR, $crashfile);
-	    File::Copy::copy($cfile, $crashfile_path);
-	    open TMPF, ">>$crashfile_path";
-	    print TMPF "\n\n";
-	    print TMPF "\/\/ this should reproduce the crash:\n";
-	    print TMPF "\/\/ $clang_delta --transformation=$which --counter=$index $crashfile_path\n";
-	    close TMPF;
-	    print "\n\n=======================================\n\n";
-	    print "OOPS: clang_delta crashed; please consider mailing\n";
-	    print "${crashfile}\n";
-	    print "to creduce-bugs\@flux.utah.edu and we will try to fix the bug\n";
-	    print "please also let us know what version of C-Reduce you are using\n";
-	    print "\n=======================================\n\n";
-	}
-	system "rm $tmpfile";
-	return ($STOP, \$index);
-    }    
+    while (1) {
+	my $counters = "--counter=$index";
+	$counters = "--order=size $counters" if $ORDER_BY_SIZE{$which};
+	my $res = run_clang_delta ($cfile, $which, $counters);
+	return ($OK, \$index) if ($res == 1);
+	return ($STOP, \$index) if ($res == 0);
+	# this variant doesn't parse, so don't bother testing it
+	$index++;
+    }
 }
 
 1;
@@ -0,0 +1,93 @@
+## -*- mode: Perl -*-
+##
+## Copyright (c) 2012 The University of Utah
+## All rights reserved.
+##
+## This file is distributed under the University of Illinois Open Source
+## License.  See the file COPYING for details.
+
+###############################################################################
+
+package pass_clang_binsrch;
+
+use strict;
+use warnings;
+
+use pass_clang;
+use creduce_utils;
+
+# Like pass_clang, but applies a whole chunk of instances in one
+# clang_delta run (--counter=A --to-counter=B), halving the chunk size
+# each time a round fails to make progress, the way pass_lines does for
+# lines.  Only for transformations that support --to-counter.
+
+sub check_prereqs () {
+    return pass_clang::check_prereqs();
+}
+
+sub new ($$) {
+    (my $cfile, my $arg) = @_;
+    my %sh;
+    $sh{"start"} = 1;
+    return \%sh;
+}
+
+sub advance ($$$) {
+    (my $cfile, my $which, my $state) = @_;
+    my %sh = %{$state};
+    return \%sh if defined($sh{"start"});
+    $sh{"index"} += $sh{"chunk"};
+    return \%sh;
+}
+
+sub round ($) {
+    (my $n) = @_;
+    return int ($n+0.5);
+}
+
+sub transform ($$$) {
+    (my $cfile, my $which, my $state) = @_;
+    my %sh = %{$state};
+
+    if (defined($sh{"start"})) {
+	delete $sh{"start"};
+	my $instances = pass_clang::query_instances ($cfile, $which);
+	return ($STOP, \%sh) if ($instances == 0);
+	$sh{"instances"} = $instances;
+	$sh{"chunk"} = $instances;
+	$sh{"index"} = 1;
+	print "initial granularity = $instances\n" if $VERBOSE;
+    }
+
+  AGAIN:
+
+    if ($sh{"index"} > $sh{"instances"}) {
+	# successful chunks removed instances, so count them again
+	$sh{"instances"} = pass_clang::query_instances ($cfile, $which);
+	return ($STOP, \%sh) if ($sh{"chunk"} == 1 || $sh{"instances"} == 0);
+	my $newchunk = round ($sh{"chunk"} / 2.0);
+	$newchunk = $sh{"instances"} if ($newchunk > $sh{"instances"});
+	$sh{"chunk"} = $newchunk;
+	$sh{"index"} = 1;
+	print "granularity = $newchunk\n" if $VERBOSE;
+    }
+
+    my $from = $sh{"index"};
+    my $to = $from + $sh{"chunk"} - 1;
+    $to = $sh{"instances"} if ($to > $sh{"instances"});
+    my $res = pass_clang::run_clang_delta ($cfile, $which,
+					   "--counter=$from --to-counter=$to");
+    return ($OK, \%sh) if ($res == 1);
+
+    if ($res == -1) {
+	# the result doesn't parse, so treat it like a failed test
+	$sh{"index"} += $sh{"chunk"};
+	goto AGAIN;
+    }
+
+    # the counter is past the instances of the current file
+    $sh{"index"} = $sh{"instances"} + 1;
+    goto AGAIN;
+}
+
+1;
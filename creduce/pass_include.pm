@@ -0,0 +1,187 @@
+## -*- mode: Perl -*-
+##
+## Copyright (c) 2012 The University of Utah
+## All rights reserved.
+##
+## This file is distributed under the University of Illinois Open Source
+## License.  See the file COPYING for details.
+
+###############################################################################
+
+# Reduces the #includes of files which have not been preprocessed.
+#
+# "remove" deletes one #include at a time.
+#
+# "inline" replaces one #include with the text of the header, the
+# smallest header first, so that the reduction can go on inside it.
+# It stops after the first header which the test accepts; creduce runs
+# it only with --inline-includes, and only when the other passes make
+# no more progress, so the file stays as small as it can be.
+#
+# Quoted headers are looked up in the directory of the file, in the
+# directories of the files being reduced, in the -I directories of
+# creduce and in the system directories of the preprocessor; angled
+# headers are looked up in the last two.
+
+package pass_include;
+
+use strict;
+use warnings;
+
+use Cwd;
+use File::Basename;
+use File::Spec;
+use File::Which;
+use creduce_utils;
+
+my $INCLUDE = qr/^[ \t]*#[ \t]*include[ \t]*([<"])([^>"\n]+)[>"][^\n]*\n?/m;
+
+# the system include directories, per language
+my %system_dirs = ();
+
+# the headers which have been inlined into each file already, so that
+# a header which includes itself is not inlined forever
+my %inlined = ();
+
+sub check_prereqs () {
+    return 1;
+}
+
+sub get_system_dirs ($) {
+    (my $lang) = @_;
+    return @{$system_dirs{$lang}} if defined($system_dirs{$lang});
+
+    my @dirs = ();
+    my $cpp = File::Which::which ("cpp");
+    if (defined($cpp) && open (my $pipe, "$cpp -x$lang -v </dev/null 2>&1 |")) {
+	my $in_list = 0;
+	while (my $line = <$pipe>) {
+	    if ($line =~ /^#include <\.\.\.> search starts here:/) {
+		$in_list = 1;
+	    } elsif ($line =~ /^End of search list\./) {
+		$in_list = 0;
+	    } elsif ($in_list && $line =~ /^\s+(\S+)/) {
+		push @dirs, $1;
+	    }
+	}
+	close $pipe;
+    }
+    $system_dirs{$lang} = \@dirs;
+    return @dirs;
+}
+
+sub find_header ($$$) {
+    (my $cfile, my $kind, my $name) = @_;
+    return (-f $name ? $name : undef) if File::Spec->file_name_is_absolute ($name);
+
+    my $lang = ($cfile =~ /\.(cc|cp|cpp|cxx|c\+\+|C|hh|hpp|hxx|H|ii)$/) ?
+	"c++" : "c";
+    my @dirs = ();
+    push @dirs, (dirname ($cfile), @QUOTE_PATHS) if ($kind eq '"');
+    push @dirs, (@INCLUDE_PATHS, get_system_dirs ($lang));
+    foreach my $dir (@dirs) {
+	my $path = "$dir/$name";
+	return Cwd::abs_path ($path) if (-f $path);
+    }
+    return undef;
+}
+
+# the #includes of $prog as [offset, length, kind, name]
+sub find_includes ($) {
+    (my $prog) = @_;
+    my @incs = ();
+    while ($prog =~ /$INCLUDE/g) {
+	push @incs, [$-[0], $+[0] - $-[0], $1, $2];
+    }
+    return @incs;
+}
+
+sub new ($$) {
+    (my $cfile, my $arg) = @_;
+    my %sh = ("index" => 0);
+    return \%sh;
+}
+
+sub advance ($$$) {
+    (my $cfile, my $arg, my $state) = @_;
+    my %sh = %{$state};
+    $sh{"index"}++;
+    delete $sh{"inlined"};
+    return \%sh;
+}
+
+# The text of a header to replace its #include with. Its own quoted
+# #includes are made absolute, since it no longer lives in its directory.
+sub header_text ($) {
+    (my $path) = @_;
+    open INF, "<$path" or return undef;
+    my $text = do { local $/; <INF> };
+    close INF;
+    $text = "" unless defined($text);
+
+    my $dir = dirname ($path);
+    $text =~ s{^([ \t]*#[ \t]*include[ \t]*)"([^"\n]+)"}{
+	my $abs = File::Spec->file_name_is_absolute ($2) ? $2 : "$dir/$2";
+	(-f $abs) ? "$1\"$abs\"" : "$1\"$2\"";
+    }gme;
+    # #pragma once means nothing in the includer
+    if ($text =~ s/^[ \t]*#[ \t]*pragma[ \t]+once[^\n]*\n?//mg) {
+	(my $guard = "CREDUCE_INLINED_$path") =~ s/\W/_/g;
+	$text = "#ifndef $guard\n#define $guard\n$text\n#endif\n";
+    }
+    $text .= "\n" unless ($text eq "" || $text =~ /\n$/);
+    return $text;
+}
+
+sub transform ($$$) {
+    (my $cfile, my $arg, my $state) = @_;
+    my %sh = %{$state};
+
+    my $key = basename ($cfile);
+    if (defined($sh{"inlined"})) {
+	# the test accepted the previous header
+	$inlined{$key}{$sh{"inlined"}} = 1;
+	return ($STOP, \%sh);
+    }
+
+    open INF, "<$cfile" or die;
+    my $prog = do { local $/; <INF> };
+    close INF;
+    $prog = "" unless defined($prog);
+    my @incs = find_includes ($prog);
+
+    if ($arg eq "remove") {
+	return ($STOP, \%sh) if ($sh{"index"} >= scalar(@incs));
+	my $inc = $incs[$sh{"index"}];
+	substr ($prog, ${$inc}[0], ${$inc}[1], "");
+    } elsif ($arg eq "inline") {
+	my @cands = ();
+	foreach my $inc (@incs) {
+	    my $path = find_header ($cfile, ${$inc}[2], ${$inc}[3]);
+	    next unless defined($path);
+	    next if $inlined{$key}{$path};
+	    push @cands, [$inc, $path, -s $path];
+	}
+	@cands = sort { ${$a}[2] <=> ${$b}[2] || ${${$a}[0]}[0] <=> ${${$b}[0]}[0] } @cands;
+	while (1) {
+	    return ($STOP, \%sh) if ($sh{"index"} >= scalar(@cands));
+	    (my $inc, my $path) = @{$cands[$sh{"index"}]};
+	    my $text = header_text ($path);
+	    if (defined($text)) {
+		substr ($prog, ${$inc}[0], ${$inc}[1], $text);
+		$sh{"inlined"} = $path;
+		last;
+	    }
+	    $sh{"index"}++;
+	}
+    } else {
+	die "unknown argument '$arg' for pass_include";
+    }
+
+    open OUTF, ">$cfile" or die;
+    print OUTF $prog;
+    close OUTF;
+    return ($OK, \%sh);
+}
+
+1;
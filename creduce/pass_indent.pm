@@ -13,14 +13,15 @@ package pass_indent;
 use strict;
 use warnings;
 
+use pass_clang;
 use creduce_utils;
 
-my $INDENT_OPTS = "-nbad -nbap -nbbb -cs -pcs -prs -saf -sai -saw -sob -ss ";
+# Reformats the file with clang_delta --format, whose output depends on
+# the tokens alone. "regular" runs in the main passes, "final" as the
+# last cleanup.
 
 sub check_prereqs () {
-    my $path1 = File::Which::which ("indent");
-    my $path2 = File::Which::which ("astyle");
-    return defined ($path1) && defined ($path2);
+    return pass_clang::check_prereqs();
 }
 
 sub new ($$) {
@@ -39,15 +40,11 @@ sub transform ($$$) {
     (my $cfile, my $arg, my $state) = @_;
     my $index = ${$state};
     return ($STOP, \$index) unless ($index == 0);
-    if (0) {
-    } elsif ($arg eq "regular") {
-	system "indent $INDENT_OPTS $cfile";
-    } elsif ($arg eq "final") {
-	system "indent $cfile";
-	system "astyle $cfile >/dev/null 2>&1";
-    } else {
-	die;
-    }
+    die unless ($arg eq "regular" || $arg eq "final");
+    my $old = read_file ($cfile);
+    return ($STOP, \$index) unless pass_clang::format_file ($cfile);
+    # already formatted, nothing to test
+    return ($STOP, \$index) if (read_file ($cfile) eq $old);
     $index++;
     return ($OK, \$index);
 }
@@ -0,0 +1,203 @@
+## -*- mode: Perl -*-
+##
+## Copyright (c) 2012 The University of Utah
+## All rights reserved.
+##
+## This file is distributed under the University of Illinois Open Source
+## License.  See the file COPYING for details.
+
+###############################################################################
+
+# Reduces preprocessed files section by section, using the line markers
+# (# <line> "<file>" <flags>) which the preprocessor leaves behind. The
+# section of a header runs from the marker entering it (flag 1) to the
+# marker returning to the includer (flag 2).
+#
+# "headers" deletes whole header sections: the outermost ones first,
+# and the largest first among those at the same depth.
+#
+# "lines" deletes chunks of lines like pass_lines, but within one
+# section at a time: the lines of the main file first, then the header
+# sections from the last one back to the first. The line markers are
+# kept, so that the sections stay intact.
+
+package pass_line_markers;
+
+use strict;
+use warnings;
+
+use creduce_utils;
+
+sub check_prereqs () {
+    return 1;
+}
+
+sub read_lines ($) {
+    (my $cfile) = @_;
+    open INF, "<$cfile" or die;
+    my @lines = <INF>;
+    close INF;
+    return @lines;
+}
+
+sub write_lines ($@) {
+    (my $cfile, my @lines) = @_;
+    open OUTF, ">$cfile" or die;
+    print OUTF @lines;
+    close OUTF;
+}
+
+sub is_marker ($) {
+    (my $line) = @_;
+    return ($line =~ /^#\s*(line\s+)?\d+\s+"/);
+}
+
+# Returns a reference to the list of header sections, each one a hash
+# with the first line (the marker entering the header), the line after
+# the marker returning to the includer, its depth (1 for a
+# header included by the main file), its size in bytes and the file
+# which included it, and a reference to the section of each line (undef
+# for the main file).
+sub parse_sections ($) {
+    (my $lines) = @_;
+    my @sections = ();
+    my @open = ();
+    my @owner = ();
+    my $file = "";
+
+    for (my $i=0; $i<scalar(@{$lines}); $i++) {
+	my $line = ${$lines}[$i];
+	if ($line =~ /^#\s*(?:line\s+)?\d+\s+"((?:[^"\\]|\\.)*)"((?:\s+\d+)*)\s*$/) {
+	    my $name = $1;
+	    my %flags = map { $_ => 1 } split (' ', $2);
+	    if ($flags{1}) {
+		my %sec = ("start" => $i, "depth" => scalar(@open) + 1,
+			   "size" => 0, "from" => $file);
+		push @open, \%sec;
+		push @sections, \%sec;
+	    } elsif ($flags{2}) {
+		# close the sections up to the one included by this file;
+		# a marker whose section was deleted matches none of them
+		my $j = $#open;
+		$j-- while ($j >= 0 && ${$open[$j]}{"from"} ne $name);
+		while ($j >= 0 && scalar(@open) > $j) {
+		    ${pop @open}{"end"} = $i + 1;
+		}
+	    }
+	    $file = $name;
+	}
+	push @owner, (@open ? $open[-1] : undef);
+	foreach my $sec (@open) {
+	    ${$sec}{"size"} += length ($line);
+	}
+    }
+    foreach my $sec (@open) {
+	${$sec}{"end"} = scalar(@{$lines});
+    }
+    return (\@sections, \@owner);
+}
+
+sub new ($$) {
+    (my $cfile, my $arg) = @_;
+    my %sh = ("index" => 0);
+    if ($arg eq "lines") {
+	$sh{"segment"} = 0;
+	$sh{"chunk"} = undef;
+    }
+    return \%sh;
+}
+
+sub advance ($$$) {
+    (my $cfile, my $arg, my $state) = @_;
+    my %sh = %{$state};
+    if ($arg eq "lines") {
+	$sh{"index"} += $sh{"chunk"};
+    } else {
+	$sh{"index"}++;
+    }
+    return \%sh;
+}
+
+sub transform_headers ($$) {
+    (my $cfile, my $state) = @_;
+    my %sh = %{$state};
+
+    my @lines = read_lines ($cfile);
+    (my $sections) = parse_sections (\@lines);
+    my @order = sort {
+	${$a}{"depth"} <=> ${$b}{"depth"} ||
+	    ${$b}{"size"} <=> ${$a}{"size"} ||
+	    ${$a}{"start"} <=> ${$b}{"start"}
+    } @{$sections};
+    return ($STOP, \%sh) if ($sh{"index"} >= scalar(@order));
+
+    my $sec = $order[$sh{"index"}];
+    splice (@lines, ${$sec}{"start"}, ${$sec}{"end"} - ${$sec}{"start"});
+    write_lines ($cfile, @lines);
+    return ($OK, \%sh);
+}
+
+# the lines of the main file, then those of each header section from
+# the last one to the first, without the markers and the nested sections
+sub segments ($) {
+    (my $lines) = @_;
+    (my $sections, my $owner) = parse_sections ($lines);
+    my %index = ();
+    for (my $s=0; $s<scalar(@{$sections}); $s++) {
+	$index{${$sections}[$s]} = scalar(@{$sections}) - $s;
+    }
+    my @segs = ([]);
+    for (my $s=0; $s<scalar(@{$sections}); $s++) {
+	push @segs, [];
+    }
+    for (my $i=0; $i<scalar(@{$lines}); $i++) {
+	next if is_marker (${$lines}[$i]);
+	my $sec = ${$owner}[$i];
+	push @{$segs[defined($sec) ? $index{$sec} : 0]}, $i;
+    }
+    return @segs;
+}
+
+sub transform_lines ($$) {
+    (my $cfile, my $state) = @_;
+    my %sh = %{$state};
+
+    my @lines = read_lines ($cfile);
+    my @segs = segments (\@lines);
+    while (1) {
+	return ($STOP, \%sh) if ($sh{"segment"} >= scalar(@segs));
+	my $seg = $segs[$sh{"segment"}];
+	if (!defined($sh{"chunk"})) {
+	    $sh{"chunk"} = scalar(@{$seg});
+	    $sh{"index"} = 0;
+	}
+	if ($sh{"chunk"} > 0 && $sh{"index"} < scalar(@{$seg})) {
+	    my $end = $sh{"index"} + $sh{"chunk"};
+	    $end = scalar(@{$seg}) if ($end > scalar(@{$seg}));
+	    my %del = map { ${$seg}[$_] => 1 } ($sh{"index"} .. $end - 1);
+	    my @out = ();
+	    for (my $i=0; $i<scalar(@lines); $i++) {
+		push @out, $lines[$i] unless $del{$i};
+	    }
+	    write_lines ($cfile, @out);
+	    return ($OK, \%sh);
+	}
+	if ($sh{"chunk"} > 1) {
+	    $sh{"chunk"} = int ($sh{"chunk"} / 2.0 + 0.5);
+	    $sh{"index"} = 0;
+	    print "granularity = $sh{chunk}\n" if $VERBOSE;
+	} else {
+	    $sh{"segment"}++;
+	    $sh{"chunk"} = undef;
+	}
+    }
+}
+
+sub transform ($$$) {
+    (my $cfile, my $arg, my $state) = @_;
+    return transform_headers ($cfile, $state) if ($arg eq "headers");
+    return transform_lines ($cfile, $state) if ($arg eq "lines");
+    die "unknown argument '$arg' for pass_line_markers";
+}
+
+1;
@@ -14,11 +14,18 @@ use strict;
 use warnings;
 
 use POSIX;
-use File::Which;
+use Digest::MD5 qw(md5_hex);
 use creduce_utils;
 
 my $BACKWARD = 0;
 
+# the last flattening for each level, as [md5 of input, md5 of output,
+# flattened text, line count]; the same pass_lines entry is listed
+# several times per round, so a file that no pass changed in between is
+# flattened once. Flattening is idempotent, so the output is its own
+# flattening as well.
+my %flatten_cache = ();
+
 sub count_lines ($) {
     (my $cfile) = @_;
     open INF, "<$cfile" or die;
@@ -29,8 +36,89 @@ sub count_lines ($) {
 }
 
 sub check_prereqs () {
-    my $path = File::Which::which ("topformflat");
-    return defined ($path);
+    return 1;
+}
+
+# Put each form whose curly-brace nesting is at most $level on a line
+# of its own, joining everything nested more deeply onto its parent's
+# line. This follows Berkeley Delta's topformflat: preprocessor
+# directives keep their own lines, and string/character literals and
+# comments are copied through untouched.
+sub flatten ($$) {
+    (my $prog, my $level) = @_;
+    my $out = "";
+    my $line = "";
+    my $nesting = 0;
+    my $parens = 0;
+    my $bol = 1;
+
+    my $newline = sub {
+	$line =~ s/\s+$//;
+	$out .= "$line\n" if ($line ne "");
+	$line = "";
+    };
+
+    while (1) {
+	if ($bol && $prog =~ /\G[ \t]*(#(?:[^\n\\]|\\.)*)(?:\n|$)/gcs) {
+	    $newline->();
+	    $out .= "$1\n";
+	    next;
+	}
+	$bol = 0;
+	if ($prog =~ /\G("(?:[^"\\]|\\.)*"|'(?:[^'\\]|\\.)*')/gcs ||
+	    $prog =~ /\G(\/\*.*?\*\/)/gcs) {
+	    $line .= $1;
+	} elsif ($prog =~ /\G(\/\/[^\n]*)\n?/gc) {
+	    $line .= $1;
+	    $newline->();
+	    $bol = 1;
+	} elsif ($prog =~ /\G\s*\n\s*/gc) {
+	    $line .= " " if ($line ne "");
+	    $bol = 1;
+	} elsif ($prog =~ /\G\{/gc) {
+	    $line .= "{";
+	    $nesting++;
+	    $newline->() if ($nesting <= $level);
+	} elsif ($prog =~ /\G\}/gc) {
+	    $newline->() if ($nesting <= $level);
+	    $nesting-- if ($nesting > 0);
+	    $line .= "}";
+	    if ($nesting <= $level) {
+		# keep the "};" ending a struct definition together
+		$line .= ";" if ($prog =~ /\G\s*;/gc);
+		$newline->();
+	    }
+	} elsif ($prog =~ /\G;/gc) {
+	    $line .= ";";
+	    $newline->() if ($nesting <= $level && $parens == 0);
+	} elsif ($prog =~ /\G([\(\)])/gc) {
+	    $line .= $1;
+	    $parens += ($1 eq "(") ? 1 : -1;
+	    $parens = 0 if ($parens < 0);
+	} elsif ($prog =~ /\G([^"'\/\n\{\};\(\)]+|.)/gcs) {
+	    my $text = $1;
+	    # a line never starts with whitespace
+	    $text =~ s/^\s+// if ($line eq "");
+	    $line .= $text;
+	} else {
+	    last;
+	}
+    }
+    $newline->();
+    return $out;
+}
+
+sub flatten_cached ($$) {
+    (my $prog, my $level) = @_;
+    my $md5 = md5_hex($prog);
+    my $res = $flatten_cache{$level};
+    if (!defined($res) || ($res->[0] ne $md5 && $res->[1] ne $md5)) {
+	my $flat = flatten ($prog, $level);
+	my $n = ($flat =~ tr/\n//);
+	$res = [$md5, md5_hex($flat), $flat, $n];
+	$flatten_cache{$level} = $res;
+    }
+    return ($res->[2], $res->[3]);
 }
 
 sub new ($$) {
@@ -68,16 +156,26 @@ sub transform ($$$) {
     if (defined $sh{"flatten"}) {
 	delete $sh{"flatten"};
 	$sh{"start"} = 1;
-	my $tmpfile = POSIX::tmpnam();
-	system "topformflat $arg < $cfile > $tmpfile";
-	system "mv $tmpfile $cfile";	
-	# print "ran topformflat $arg\n";
-	return ($OK, \%sh);
+	open INF, "<$cfile" or die;
+	my $prog = do { local $/; <INF> };
+	close INF;
+	(my $flat, my $n) = flatten_cached ($prog, $arg);
+	# only hand the flattened file to the delta test when flattening
+	# actually changed something
+	if ($flat ne $prog) {
+	    open OUTF, ">$cfile" or die;
+	    print OUTF $flat;
+	    close OUTF;
+	    return ($OK, \%sh);
+	}
+	$sh{"lines"} = $n;
     }
 
     if (defined($sh{"start"})) {
 	delete $sh{"start"};
-	my $chunk = count_lines($cfile);
+	my $chunk = $sh{"lines"};
+	delete $sh{"lines"};
+	$chunk = count_lines($cfile) unless defined($chunk);
 	$sh{"chunk"} = $chunk;
 	print "initial granularity = $chunk\n" if $VERBOSE;
 	if ($BACKWARD) {
@@ -0,0 +1,69 @@
+#!/bin/bash
+##
+## Copyright (c) 2012 The University of Utah
+## All rights reserved.
+##
+## This file is distributed under the University of Illinois Open Source
+## License.  See the file COPYING for details.
+
+###############################################################################
+
+# test0.sh as a persistent test for `creduce --persistent-test': it reads
+# the absolute paths of the variants from its standard input, one per
+# line, and answers each one with a line "1" (interesting) or "0".
+# Nothing else may be written to the standard output. The warnings are
+# matched by a single grep per compiler instead of one grep per warning.
+
+interesting() {
+  rm -f out*.txt
+  clang -pedantic -Wall -O0 "$1" >out.txt 2>&1 &&\
+  ! grep -q \
+    -e 'incompatible redeclaration' \
+    -e 'ordered comparison between pointer' \
+    -e 'eliding middle term' \
+    -e 'end of non-void function' \
+    -e 'invalid in C99' \
+    -e 'specifies type' \
+    -e 'should return a value' \
+    -e 'too few argument' \
+    -e 'too many argument' \
+    -e "return type of 'main" \
+    -e 'uninitialized' \
+    -e 'incompatible pointer to' \
+    -e 'incompatible integer to' \
+    -e 'type specifier missing' \
+    out.txt &&\
+  gcc -c -Wall -Wextra -O "$1" >outa.txt 2>&1 &&\
+  ! grep -q \
+    -e uninitialized \
+    -e 'control reaches end' \
+    -e 'no semicolon at end' \
+    -e 'incompatible pointer' \
+    -e 'cast from pointer to integer' \
+    -e 'ordered comparison of pointer with integer' \
+    -e 'declaration does not declare anything' \
+    -e 'expects type' \
+    -e 'assumed to have one element' \
+    -e 'division by zero' \
+    -e 'pointer from integer' \
+    -e 'incompatible implicit' \
+    -e 'excess elements in struct initializer' \
+    -e 'comparison between pointer and integer' \
+    outa.txt &&\
+  grep -q 'goto' "$1"
+}
+
+if [ -z "$CREDUCE_TEST_SERVER" ]; then
+  echo "usage: creduce --persistent-test $0 <file.c>" 1>&2
+  exit 1
+fi
+
+while read -r variant; do
+  # each variant lives in its own temporary directory
+  if (cd "$(dirname "$variant")" && interesting "$variant") >/dev/null 2>&1
+  then
+    echo 1
+  else
+    echo 0
+  fi
+done